@@ -8,9 +8,12 @@ in vec2 vertexTexCoord;
 in vec3 vertexNormal;
 in vec4 vertexColor;
 
-//in vec4 colDiffuse;
-in vec4 direction; // Line screen direction (xy), line width (z), line color packed (w)
-in mat4 matModel;
+// Line endpoints (world space), width (clip space) and color, one instance per segment.
+// The quad (GenMeshPlaneY) is expanded along the segment as projected in each view
+in vec3 lineStart;
+in vec3 lineEnd;
+in float lineWidth;
+in vec4 lineColor;
 
 // Input uniform values
 uniform mat4 matView;
@@ -20,36 +23,41 @@ uniform mat4 matProjection;
 out vec2 fragTexCoord;
 out vec4 fragColor;
 
-vec3 unpackColor(float value) {
-	vec3 color;
-	color.r = mod(value, 129.0) / 128.0;
-	color.b = mod(floor(value / 129.0), 129.0) / 128.0;
-	color.g = floor(value / (129.0 * 129.0)) / 128.0;
-	return color;
-}
-
 void main()
 {
     // Send vertex attributes to fragment shader
     fragTexCoord = vertexTexCoord;
 
-    vec4 modelPos = matModel*vec4(vertexPosition, 1.0);
+#ifdef MULTIVIEW
+    mat4 matViewProjection = MultiviewViewProjection();
+    vec4 rect = viewRect[MultiviewIndex()];
+    float aspect = rect.z/rect.w;
+#else
+    mat4 matViewProjection = matProjection*matView;
+    float aspect = matProjection[1][1]/matProjection[0][0];
+#endif
 
-    float aspect = 1536.0/2048.0;
+    vec4 projectedStart = matViewProjection*vec4(lineStart, 1.0);
+    vec4 projectedEnd = matViewProjection*vec4(lineEnd, 1.0);
 
-    vec4 projectedPos = (matProjection*matView*matModel) * vec4(vertexPosition, 1.0);
+    // Direction on screen, in square units so the width is the same along x and y
+    vec2 screenDir = projectedEnd.xy/projectedEnd.w - projectedStart.xy/projectedStart.w;
+    screenDir.x *= aspect;
+    float screenLength = length(screenDir);
+    screenDir = screenLength > 0.0 ? screenDir/screenLength : vec2(0.0, 1.0);
 
-    vec2 screenDir = direction.xy;
     vec2 screenNormal = vec2(-screenDir.y, screenDir.x);
-    screenNormal *= direction.z;
+    screenNormal *= lineWidth;
     screenNormal.x /= aspect;
     screenNormal *= (vertexTexCoord.x < 0.5 ? 1.0 : -1.0);
 
     vec4 offset = vec4(screenNormal.xy, 0.0, 0.0);
 
-    //gl_Position = (matProjection*matView*matModel)*vec4(vertexPosition, 1.0);
-    gl_Position = projectedPos + offset;
-    fragColor = vec4(unpackColor(direction.w), 1.0);
+    gl_Position = mix(projectedStart, projectedEnd, vertexPosition.y + 0.5) + offset;
+#ifdef MULTIVIEW
+    gl_Position = MultiviewTile(gl_Position);
+#endif
+    fragColor = vec4(lineColor.rgb, 1.0);
 }
 
 #endif
@@ -66,6 +74,9 @@ uniform float glow;
 uniform float glowFalloff;
 
 void main (void) {
+#ifdef MULTIVIEW
+    MultiviewClip();
+#endif
     //finalColor = fragColor;
     finalColor = mix(fragColor,
         mix(fragColor, vec4(1,1,1,1), glow),
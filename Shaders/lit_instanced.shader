@@ -8,14 +8,23 @@ in vec2 vertexTexCoord;
 in vec3 vertexNormal;
 in vec4 vertexColor;
 
+#ifdef COMPACT_INSTANCE
+// CompactInstance, see raylib_extensions.h
+in vec3 instancePosition;
+in vec3 instanceScale;
+in vec4 instanceRotation;
+in vec4 instanceColor;
+#else
 in vec4 colDiffuse;
 in mat4 matModel;
+#endif
 
 // Input uniform values
 uniform mat4 mvp;
 uniform mat4 matView;
 uniform mat4 matProjection;
 
+// Shadow pass
 uniform vec3 shadowColor;
 uniform vec3 lightPos;
 uniform float planeZ;
@@ -24,23 +33,49 @@ uniform float planeZ;
 out vec2 fragTexCoord;
 out vec4 fragColor;
 
+#ifdef COMPACT_INSTANCE
+mat4 composeTransform(vec3 position, vec4 q, vec3 scale) {
+    q = normalize(q);
+    mat3 rotation = mat3(
+        1.0 - 2.0*(q.y*q.y + q.z*q.z), 2.0*(q.x*q.y + q.w*q.z), 2.0*(q.x*q.z - q.w*q.y),
+        2.0*(q.x*q.y - q.w*q.z), 1.0 - 2.0*(q.x*q.x + q.z*q.z), 2.0*(q.y*q.z + q.w*q.x),
+        2.0*(q.x*q.z + q.w*q.y), 2.0*(q.y*q.z - q.w*q.x), 1.0 - 2.0*(q.x*q.x + q.y*q.y));
+    return mat4(
+        vec4(rotation[0]*scale.x, 0.0),
+        vec4(rotation[1]*scale.y, 0.0),
+        vec4(rotation[2]*scale.z, 0.0),
+        vec4(position, 1.0));
+}
+#endif
+
 void main()
 {
+#ifdef COMPACT_INSTANCE
+    mat4 matModel = composeTransform(instancePosition, instanceRotation, instanceScale);
+    vec4 colDiffuse = instanceColor;
+#endif
+
     // Send vertex attributes to fragment shader
     fragTexCoord = vertexTexCoord;
 
+#ifdef MULTIVIEW
+    mat4 matViewProjection = MultiviewViewProjection();
+#else
+    mat4 matViewProjection = matProjection*matView;
+#endif
+
     vec4 modelPos = matModel*vec4(vertexPosition, 1.0);
+
+#ifndef SHADOW_PASS
     vec3 lightDir = normalize(vec3(-3.0, 5.0, 8.0) - modelPos.xyz);
     float diff = (max(dot(vertexNormal, lightDir), 0.0) + 0.2);
 
-    if (colDiffuse.a < 0.5) {
-        //float gradient = (modelPos.y + 1.0)/2.0;
-        //gradient = mix(0.3, 1.0, gradient);
-        fragColor = vec4((diff * colDiffuse).xyz, 1.0);
-        gl_Position = (matProjection*matView*matModel)*vec4(vertexPosition, 1.0);
-        return;
-    }
-    
+    //float gradient = (modelPos.y + 1.0)/2.0;
+    //gradient = mix(0.3, 1.0, gradient);
+    fragColor = vec4((diff * colDiffuse).xyz, 1.0);
+    gl_Position = (matViewProjection*matModel)*vec4(vertexPosition, 1.0);
+#else
+    // Planar shadow, a second pass over the same instances (see ShadowPass)
     fragColor = vec4(shadowColor, 1.0);
 
     //See: https://math.stackexchange.com/questions/35857/two-point-line-form-in-3d 
@@ -56,7 +91,11 @@ void main()
     float z = viewPlaneZ;
     
     // Calculate final vertex position
-    gl_Position = matProjection*(matView*vec4(x, y, z, 1.0));
+    gl_Position = matViewProjection*vec4(x, y, z, 1.0);
+#endif
+#ifdef MULTIVIEW
+    gl_Position = MultiviewTile(gl_Position);
+#endif
 }
 
 #endif
@@ -70,6 +109,9 @@ in vec4 fragColor;
 out vec4 finalColor;
 
 void main (void) {
+#ifdef MULTIVIEW
+    MultiviewClip();
+#endif
     finalColor = fragColor;
 }
 
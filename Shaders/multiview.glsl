@@ -0,0 +1,49 @@
+// Multiview prelude, prepended by LoadShaderSingleFile to shaders that reference MULTIVIEW
+// Every instance is repeated once per view (attribute divisor = view count), so the view
+// index is gl_InstanceID % viewCount and each view is moved into its own quilt tile
+#define MULTIVIEW
+
+precision highp float;
+
+layout(std140) uniform Multiview {
+    mat4 viewProjection[MULTIVIEW_MAX_VIEWS];
+    vec4 viewRect[MULTIVIEW_MAX_VIEWS]; // Tile x, y, width, height (quilt pixels)
+    vec4 quiltInfo;                     // Quilt width, height, view count
+};
+
+#ifdef VERTEX
+
+flat out int multiviewIndex;
+
+int MultiviewIndex() {
+    return gl_InstanceID % int(quiltInfo.z);
+}
+
+mat4 MultiviewViewProjection() {
+    return viewProjection[MultiviewIndex()];
+}
+
+// Map a clip space position of the current view into its tile of the quilt
+vec4 MultiviewTile(vec4 clip) {
+    multiviewIndex = MultiviewIndex();
+    vec4 rect = viewRect[multiviewIndex];
+
+    vec2 scale = rect.zw / quiltInfo.xy;
+    vec2 bias = (rect.xy * 2.0 + rect.zw) / quiltInfo.xy - 1.0;
+    return vec4(clip.xy * scale + bias * clip.w, clip.zw);
+}
+
+#endif
+#ifdef FRAGMENT
+
+flat in int multiviewIndex;
+
+// Triangles are only clipped against the whole quilt, drop fragments spilling into a neighbouring tile
+void MultiviewClip() {
+    vec4 rect = viewRect[multiviewIndex];
+    vec2 p = gl_FragCoord.xy - rect.xy;
+    if (p.x < 0.0 || p.y < 0.0 || p.x >= rect.z || p.y >= rect.w)
+        discard;
+}
+
+#endif
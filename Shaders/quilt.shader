@@ -1,4 +1,8 @@
+#ifdef QUILT_HIGHP
+precision highp float;
+#else
 precision mediump float;
+#endif
 
 #ifdef VERTEX
 
@@ -33,10 +37,19 @@ void main()
 //See: https://github.com/patriciogonzalezvivo/glslViewer/blob/main/src/shaders/holoplay.h
 // QUILT TEXTURE
 //uniform sampler2D texture0;
+#ifdef QUILT_LAYERED
+// One layer per view (see quilt.h)
+uniform mediump sampler2DArray texture1;
+#else
 uniform sampler2D texture1;
+#endif
 
-//uniform vec2        resolution;
-vec2 resolution = vec2(1536, 2048);
+#ifdef QUILT_LUT
+// View index of every subpixel, baked with QUILT_BAKE_LUT (see interleaver.h)
+uniform sampler2D lut;
+#endif
+
+uniform vec2 resolution;
 uniform vec2 tile;
 //uniform vec4 holoPlayCalibration;  // dpi, pitch, slope, center
 //uniform vec2 holoPlayRB;           // ri, bi
@@ -50,7 +63,7 @@ in vec2 fragTexCoord;
 out vec4 finalColor;
 
 // GET CORRECT VIEW
-vec2 quilt_map(vec3 t, vec2 pos, float a) {
+vec2 quilt_tile(vec3 t, float a) {
     vec2 tile2 = vec2(t.x - 1.0, t.y - 1.0);
     vec2 dir = vec2(-1.0, -1.0);
     
@@ -58,17 +71,17 @@ vec2 quilt_map(vec3 t, vec2 pos, float a) {
     tile2.y += dir.y * floor(a);
     a = fract(a) * t.x;
     tile2.x += dir.x * floor(a);
-    
-    //Vertically flip quilt uvs, I don't know why this is necessary
-    return ((tile2 + pos) / t.xy);// * vec2(1,-1) + vec2(0, 1);
+    return tile2;
+}
+float quilt_view(vec3 t, float a) {
+    vec2 tile2 = quilt_tile(t, a);
+    return tile2.y * t.x + tile2.x;
 }
 
-void main (void) {
+// View index of each subpixel, only depends on the calibration
+vec3 quilt_views(vec2 st) {
     vec4 holoPlayCalibration = vec4(dpi, pitch, slope, center);
-    
-    vec3 color = vec3(0.0);
-    vec2 uv = gl_FragCoord.xy;
-    vec2 st = uv/resolution.xy;
+    vec3 t = vec3(tile.xy, tile.x * tile.y);
     
     float pitch = -resolution.x / holoPlayCalibration.x  * holoPlayCalibration.y * sin(atan(abs(holoPlayCalibration.z)));
     float tilt = resolution.y / (resolution.x * holoPlayCalibration.z);
@@ -77,18 +90,71 @@ void main (void) {
     float subp2 = subp * pitch;
     
     float a = (-st.x - st.y * tilt) * pitch - holoPlayCalibration.w;
-    color.r = texture(texture1, quilt_map(vec3(tile.xy, tile.x * tile.y), st, a - 0.0 * subp2)).r;
-    color.g = texture(texture1, quilt_map(vec3(tile.xy, tile.x * tile.y), st, a - 1.0 * subp2)).g;
-    color.b = texture(texture1, quilt_map(vec3(tile.xy, tile.x * tile.y), st, a - 2.0 * subp2)).b;
+    return vec3(
+        quilt_view(t, a - 0.0 * subp2),
+        quilt_view(t, a - 1.0 * subp2),
+        quilt_view(t, a - 2.0 * subp2));
+}
+
+// SAMPLE VIEW
+#ifdef QUILT_LAYERED
+// Sample the view's own layer so tiles can't bleed into each other
+vec4 quilt_sample(vec2 t, vec2 pos, float view) {
+    return texture(texture1, vec3(pos, view));
+}
+// Sample the layers as if they were laid out in an atlas
+vec4 quilt_sample_atlas(vec2 t, vec2 st) {
+    vec2 tile2 = floor(st * t);
+    return texture(texture1, vec3(fract(st * t), tile2.y * t.x + tile2.x));
+}
+#else
+vec4 quilt_sample(vec2 t, vec2 pos, float view) {
+    vec2 tile2 = vec2(mod(view, t.x), floor(view / t.x));
+    
+    //Vertically flip quilt uvs, I don't know why this is necessary
+    return texture(texture1, (tile2 + pos) / t.xy);// * vec2(1,-1) + vec2(0, 1);
+}
+vec4 quilt_sample_atlas(vec2 t, vec2 st) {
+    return texture(texture1, st);
+}
+#endif
+
+void main (void) {
+    vec3 color = vec3(0.0);
+    vec2 uv = gl_FragCoord.xy;
+    vec2 st = uv/resolution.xy;
+    
+    #if defined(QUILT_LUT)
+    vec3 views = floor(texelFetch(lut, ivec2(uv), 0).rgb * 255.0 + 0.5);
+    #else
+    vec3 views = quilt_views(st);
+    #endif
+    
+    #if defined(QUILT_BAKE_LUT)
+    finalColor = vec4(views / 255.0, 1.0);
+    return;
+    #endif
+    
+    color.r = quilt_sample(tile.xy, st, views.r).r;
+    color.g = quilt_sample(tile.xy, st, views.g).g;
+    color.b = quilt_sample(tile.xy, st, views.b).b;
+    
+    #if defined(QUILT_LUT_COMPARE)
+    // Highlight subpixels where the baked view differs from the analytic one
+    vec3 analytic = quilt_views(st);
+    if (any(notEqual(views, analytic)))
+        color = vec3(1.0, 0.0, 1.0);
+    #endif
     
     #if defined(HOLOPLAY_DEBUG_CENTER)
     // Mark center line only in central view
+    float a = quilt_views(st).r / (tile.x * tile.y);
     color.r = color.r * 0.001 + (st.x>0.49 && st.x<0.51 && fract(a)>0.48&&fract(a)<0.51 ?1.0:0.0);
     color.g = color.g * 0.001 + st.x;
     color.b = color.b * 0.001 + st.y;
     #elif defined(HOLOPLAY_DEBUG)
     // use quilt texture
-    color = texture(texture1, st).rgb;
+    color = quilt_sample_atlas(tile.xy, st).rgb;
     #endif
     
     finalColor = vec4(color,1.0);
@@ -0,0 +1,100 @@
+precision highp float;
+
+#ifdef VERTEX
+
+// Input vertex attributes
+in vec3 vertexPosition;
+in vec2 vertexTexCoord;
+in vec3 vertexNormal;
+in vec4 vertexColor;
+
+// Input uniform values
+uniform mat4 mvp;
+
+// Output vertex attributes (to fragment shader)
+out vec2 fragTexCoord;
+out vec4 fragColor;
+
+void main()
+{
+    // Send vertex attributes to fragment shader
+    fragTexCoord = vertexTexCoord;
+    fragColor = vertexColor;
+
+    // Calculate final vertex position
+    gl_Position = mvp*vec4(vertexPosition, 1.0);
+}
+
+#endif
+#ifdef FRAGMENT
+
+// Rebuilds a view of the quilt from the two rendered (key) views around it, see synthesis.h
+// Views only differ by a horizontal camera offset with a shared focal plane, so a point at
+// distance z moves by baseline * disparityScale * (1/z - 1/focalDistance) in uv units
+
+// KEY VIEWS
+uniform highp sampler2DArray keyColor;
+uniform highp sampler2DArray keyDepth;
+
+uniform vec2 viewOrigin;        // Target view's tile origin in framebuffer pixels
+uniform vec2 tileSize;
+uniform vec2 keyLayers;         // Layers of the key views left and right of this view
+uniform vec3 offsets;           // Camera offsets of this view and the left and right key views
+uniform float disparityScale;   // Half the projection's x scale
+uniform float focalDistance;
+uniform vec2 clipPlanes;        // Near, far
+
+// IN OUT
+in vec2 fragTexCoord;
+out vec4 finalColor;
+
+// A disocclusion can't be reprojected within this many pixels, use the other key view instead
+const float MAX_ERROR = 1.0;
+const int ITERATIONS = 3;
+
+float linear_depth(float depth) {
+    float z = depth * 2.0 - 1.0;
+    return 2.0 * clipPlanes.x * clipPlanes.y / (clipPlanes.y + clipPlanes.x - z * (clipPlanes.y - clipPlanes.x));
+}
+
+float disparity(float depth, float baseline) {
+    return baseline * disparityScale * (1.0 / linear_depth(depth) - 1.0 / focalDistance);
+}
+
+// Backward warp: find the key view texel that lands on uv, by fixed point iteration on its depth.
+// error is how far (in pixels) the found texel actually lands from uv
+vec4 warp(vec2 uv, float layer, float baseline, out float error) {
+    vec2 source = uv;
+    for (int i = 0; i < ITERATIONS; i++) {
+        float depth = texture(keyDepth, vec3(source, layer)).r;
+        source.x = uv.x + disparity(depth, baseline);
+    }
+
+    float depth = texture(keyDepth, vec3(source, layer)).r;
+    error = abs(uv.x + disparity(depth, baseline) - source.x) * tileSize.x;
+    if (source.x < 0.0 || source.x > 1.0)
+        error = 1e6;
+    return texture(keyColor, vec3(source, layer));
+}
+
+void main (void) {
+    vec2 uv = (gl_FragCoord.xy - viewOrigin) / tileSize;
+
+    float errorLeft, errorRight;
+    vec4 left = warp(uv, keyLayers.x, offsets.x - offsets.y, errorLeft);
+    vec4 right = warp(uv, keyLayers.y, offsets.x - offsets.z, errorRight);
+
+    // Blend by distance to each key view, unless one of them can't see this point
+    float t = offsets.z == offsets.y ? 0.0 : (offsets.x - offsets.y) / (offsets.z - offsets.y);
+    bool validLeft = errorLeft < MAX_ERROR;
+    bool validRight = errorRight < MAX_ERROR;
+
+    if (validLeft == validRight && (validLeft || errorLeft == errorRight))
+        finalColor = mix(left, right, t);
+    else if (validLeft || (!validRight && errorLeft < errorRight))
+        finalColor = left;
+    else
+        finalColor = right;
+}
+
+#endif
@@ -36,7 +36,11 @@ void main()
     float diff = (max(dot(vertexNormal, lightDir), 0.0) + 0.2);*/
 
     fragColor = vec4((/*diff * */colDiffuse).xyz, 1.0);
+#ifdef MULTIVIEW
+    gl_Position = MultiviewTile((MultiviewViewProjection()*matModel)*vec4(vertexPosition, 1.0));
+#else
     gl_Position = (matProjection*matView*matModel)*vec4(vertexPosition, 1.0);
+#endif
     return;
 }
 
@@ -53,6 +57,9 @@ in vec4 fragColor;
 out vec4 finalColor;
 
 void main (void) {
+#ifdef MULTIVIEW
+    MultiviewClip();
+#endif
     finalColor = texture(texture1, fragTexCoord);
     finalColor = vec4(finalColor.rgb * fragColor.rgb, finalColor.a);
     if (finalColor.a < 0.5)
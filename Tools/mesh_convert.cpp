@@ -0,0 +1,433 @@
+// Converts a Wavefront OBJ mesh to the preprocessed format LoadPackedMesh maps (see meshformat.h).
+// Usage: mesh_convert <in.obj> <out.lkgm> [--lods <1-8>] [--cache-size <vertices>]
+// Faces are triangulated and every object is merged into one mesh. Positions, normals and texcoords are
+// quantized, indices reordered for the vertex cache (Tipsify) and every LOD after the first simplified by
+// vertex clustering to about half the triangles of the one before. glTF isn't read, export OBJ instead.
+// Exits with 0 when the mesh was written, 2 on bad input.
+#include "../meshformat.h"
+
+#include <map>
+#include <set>
+#include <cmath>
+#include <array>
+#include <tuple>
+#include <string>
+#include <vector>
+#include <cstring>
+#include <cstdlib>
+#include <fstream>
+#include <sstream>
+#include <iostream>
+#include <stdexcept>
+#include <algorithm>
+
+struct Vertex {
+    float position[3];
+    float normal[3];
+    float texcoord[2];
+};
+
+struct MeshData {
+    std::vector<Vertex> vertices;
+    std::vector<uint32_t> indices;
+};
+
+// OBJ indices start at 1, negative ones count back from the last element so far. -1 when missing,
+// below -1 when it points before the first element (0, or counting back too far).
+// Throws std::invalid_argument or std::out_of_range for tokens that aren't a number
+int ResolveIndex(const std::string& str, size_t count)
+{
+    if (str.empty()) return -1;
+    size_t end = 0;
+    int index = std::stoi(str, &end);
+    if (end != str.size()) throw std::invalid_argument(str);
+    int resolved = index < 0 ? (int)count + index : index - 1;
+    return resolved < 0 ? -2 : resolved;
+}
+
+void Normalize(float* v)
+{
+    float length = std::sqrt(v[0]*v[0] + v[1]*v[1] + v[2]*v[2]);
+    if (length > 0.0f) for (int i = 0; i < 3; i++) v[i] /= length;
+}
+
+// Vertices are unique (position, texcoord, normal) triples, vertices without a normal get the
+// area weighted average of their faces'
+bool LoadOBJ(const std::string& path, MeshData& mesh)
+{
+    std::ifstream file(path);
+    if (!file) return false;
+
+    std::vector<std::array<float, 3>> positions, normals;
+    std::vector<std::array<float, 2>> texcoords;
+    std::map<std::tuple<int, int, int>, uint32_t> unique;
+    std::vector<bool> smooth;   // Per vertex, the normal is computed
+
+    std::string line;
+    while (std::getline(file, line)) {
+        std::istringstream stream(line);
+        std::string type;
+        stream >> type;
+        if (type == "v") {
+            std::array<float, 3> v = { 0 };
+            stream >> v[0] >> v[1] >> v[2];
+            positions.push_back(v);
+        } else if (type == "vn") {
+            std::array<float, 3> n = { 0 };
+            stream >> n[0] >> n[1] >> n[2];
+            normals.push_back(n);
+        } else if (type == "vt") {
+            std::array<float, 2> t = { 0 };
+            stream >> t[0] >> t[1];
+            texcoords.push_back(t);
+        } else if (type == "f") {
+            std::vector<uint32_t> face;
+            std::string corner;
+            while (stream >> corner) {
+                // v, v/vt, v//vn or v/vt/vn
+                size_t first = corner.find('/');
+                size_t second = first == std::string::npos ? std::string::npos : corner.find('/', first + 1);
+                int v = -1, vt = -1, vn = -1;
+                try {
+                    v = ResolveIndex(corner.substr(0, first), positions.size());
+                    if (first != std::string::npos)
+                        vt = ResolveIndex(corner.substr(first + 1, second == std::string::npos ? std::string::npos : second - first - 1), texcoords.size());
+                    if (second != std::string::npos) vn = ResolveIndex(corner.substr(second + 1), normals.size());
+                } catch (const std::exception&) {
+                    v = -1;
+                }
+                // Texcoords and normals may be missing (-1), but not point outside their elements
+                if (v < 0 || v >= (int)positions.size() || vt < -1 || vt >= (int)texcoords.size() || vn < -1 || vn >= (int)normals.size()) {
+                    std::cout << "FAIL: Bad face '" << line << "'\n";
+                    return false;
+                }
+
+                auto key = std::make_tuple(v, vt, vn);
+                auto it = unique.find(key);
+                if (it == unique.end()) {
+                    Vertex vertex = { };
+                    std::copy(positions[v].begin(), positions[v].end(), vertex.position);
+                    // Flipped like raylib's OBJ loader, images are stored top to bottom
+                    if (vt >= 0) {
+                        vertex.texcoord[0] = texcoords[vt][0];
+                        vertex.texcoord[1] = 1.0f - texcoords[vt][1];
+                    }
+                    if (vn >= 0) std::copy(normals[vn].begin(), normals[vn].end(), vertex.normal);
+                    it = unique.emplace(key, (uint32_t)mesh.vertices.size()).first;
+                    mesh.vertices.push_back(vertex);
+                    smooth.push_back(vn < 0);
+                }
+                face.push_back(it->second);
+            }
+            // Fan, faces are convex
+            for (size_t i = 2; i < face.size(); i++) {
+                mesh.indices.push_back(face[0]);
+                mesh.indices.push_back(face[i - 1]);
+                mesh.indices.push_back(face[i]);
+            }
+        }
+    }
+
+    for (size_t i = 0; i < mesh.indices.size(); i += 3) {
+        Vertex* v[3] = { &mesh.vertices[mesh.indices[i]], &mesh.vertices[mesh.indices[i + 1]], &mesh.vertices[mesh.indices[i + 2]] };
+        float a[3], b[3];
+        for (int k = 0; k < 3; k++) {
+            a[k] = v[1]->position[k] - v[0]->position[k];
+            b[k] = v[2]->position[k] - v[0]->position[k];
+        }
+        float n[3] = { a[1]*b[2] - a[2]*b[1], a[2]*b[0] - a[0]*b[2], a[0]*b[1] - a[1]*b[0] };
+        for (int j = 0; j < 3; j++) {
+            if (!smooth[mesh.indices[i + j]]) continue;
+            for (int k = 0; k < 3; k++) v[j]->normal[k] += n[k];
+        }
+    }
+    for (Vertex& vertex : mesh.vertices) Normalize(vertex.normal);
+    return !mesh.indices.empty();
+}
+
+// Merges the vertices in each cell of a grid x grid x grid grid over the bounds (and facing the same
+// axis, so hard edges stay hard) into their average, then drops the triangles that collapsed
+MeshData Cluster(const MeshData& mesh, int grid, const float* center, float extent)
+{
+    MeshData result;
+    std::map<std::tuple<int, int, int, int>, uint32_t> cells;
+    std::vector<uint32_t> remap(mesh.vertices.size());
+    std::vector<int> counts;
+
+    for (size_t i = 0; i < mesh.vertices.size(); i++) {
+        const Vertex& vertex = mesh.vertices[i];
+        int cell[3];
+        for (int k = 0; k < 3; k++) {
+            float unit = ((vertex.position[k] - center[k]) / extent) * 0.5f + 0.5f;
+            cell[k] = std::min(grid - 1, std::max(0, (int)(unit * grid)));
+        }
+        int axis = 0;
+        for (int k = 1; k < 3; k++) if (std::fabs(vertex.normal[k]) > std::fabs(vertex.normal[axis])) axis = k;
+        int facing = axis*2 + (vertex.normal[axis] < 0.0f ? 1 : 0);
+
+        auto it = cells.emplace(std::make_tuple(cell[0], cell[1], cell[2], facing), (uint32_t)result.vertices.size()).first;
+        if (it->second == result.vertices.size()) {
+            result.vertices.push_back(Vertex{ });
+            counts.push_back(0);
+        }
+        Vertex& merged = result.vertices[it->second];
+        for (int k = 0; k < 3; k++) merged.position[k] += vertex.position[k];
+        for (int k = 0; k < 3; k++) merged.normal[k] += vertex.normal[k];
+        for (int k = 0; k < 2; k++) merged.texcoord[k] += vertex.texcoord[k];
+        counts[it->second]++;
+        remap[i] = it->second;
+    }
+    for (size_t i = 0; i < result.vertices.size(); i++) {
+        for (int k = 0; k < 3; k++) result.vertices[i].position[k] /= counts[i];
+        for (int k = 0; k < 2; k++) result.vertices[i].texcoord[k] /= counts[i];
+        Normalize(result.vertices[i].normal);
+    }
+
+    std::set<std::array<uint32_t, 3>> triangles;
+    for (size_t i = 0; i < mesh.indices.size(); i += 3) {
+        uint32_t a = remap[mesh.indices[i]], b = remap[mesh.indices[i + 1]], c = remap[mesh.indices[i + 2]];
+        if (a == b || b == c || a == c) continue;
+        // The same triangle from several source ones, in any winding-preserving rotation
+        std::array<uint32_t, 3> key = { a, b, c };
+        std::rotate(key.begin(), std::min_element(key.begin(), key.end()), key.end());
+        if (!triangles.insert(key).second) continue;
+        result.indices.push_back(a);
+        result.indices.push_back(b);
+        result.indices.push_back(c);
+    }
+    return result;
+}
+
+// Triangle order for a FIFO vertex cache of cacheSize vertices, after Sander et al., "Fast
+// Triangle Reordering for Vertex Locality and Reduced Overdraw" (Tipsify)
+std::vector<uint32_t> Tipsify(const std::vector<uint32_t>& indices, size_t vertexCount, int cacheSize)
+{
+    size_t triangleCount = indices.size() / 3;
+
+    // Triangles using each vertex
+    std::vector<uint32_t> offsets(vertexCount + 1, 0);
+    for (uint32_t v : indices) offsets[v + 1]++;
+    for (size_t v = 0; v < vertexCount; v++) offsets[v + 1] += offsets[v];
+    std::vector<uint32_t> adjacency(indices.size());
+    std::vector<uint32_t> fill(offsets.begin(), offsets.end() - 1);
+    for (size_t i = 0; i < indices.size(); i++) adjacency[fill[indices[i]]++] = i / 3;
+
+    std::vector<int> live(vertexCount);
+    for (size_t v = 0; v < vertexCount; v++) live[v] = offsets[v + 1] - offsets[v];
+    std::vector<int> timestamps(vertexCount, 0);
+    std::vector<bool> emitted(triangleCount, false);
+    std::vector<uint32_t> deadEnd;
+    std::vector<uint32_t> output;
+    output.reserve(indices.size());
+
+    int time = cacheSize + 1;
+    size_t cursor = 0;
+    long fanning = -1;
+    while (fanning == -1 && cursor < vertexCount) if (live[cursor++] > 0) fanning = cursor - 1;
+
+    while (fanning != -1) {
+        std::vector<uint32_t> candidates;
+        for (uint32_t i = offsets[fanning]; i < offsets[fanning + 1]; i++) {
+            uint32_t t = adjacency[i];
+            if (emitted[t]) continue;
+            for (int k = 0; k < 3; k++) {
+                uint32_t v = indices[t*3 + k];
+                output.push_back(v);
+                deadEnd.push_back(v);
+                candidates.push_back(v);
+                live[v]--;
+                if (time - timestamps[v] > cacheSize) timestamps[v] = time++;
+            }
+            emitted[t] = true;
+        }
+
+        // Next, the candidate still in the cache after its remaining triangles, the oldest of those
+        fanning = -1;
+        int best = -1;
+        for (uint32_t v : candidates) {
+            if (live[v] <= 0) continue;
+            int priority = time - timestamps[v] + 2*live[v] <= cacheSize ? time - timestamps[v] : 0;
+            if (priority > best) {
+                best = priority;
+                fanning = v;
+            }
+        }
+        // Dead end: the most recent vertex with triangles left, else the next one in input order
+        while (fanning == -1 && !deadEnd.empty()) {
+            uint32_t v = deadEnd.back();
+            deadEnd.pop_back();
+            if (live[v] > 0) fanning = v;
+        }
+        while (fanning == -1 && cursor < vertexCount) if (live[cursor++] > 0) fanning = cursor - 1;
+    }
+    return output;
+}
+
+// Vertices in the order the indices first use them, so fetches walk the buffer forwards
+void OptimizeVertexOrder(MeshData& mesh)
+{
+    std::vector<uint32_t> remap(mesh.vertices.size(), UINT32_MAX);
+    std::vector<Vertex> vertices;
+    for (uint32_t& index : mesh.indices) {
+        if (remap[index] == UINT32_MAX) {
+            remap[index] = vertices.size();
+            vertices.push_back(mesh.vertices[index]);
+        }
+        index = remap[index];
+    }
+    mesh.vertices = vertices;
+}
+
+// Average cache misses per triangle with a FIFO cache, 0.5 is the best a regular grid gets
+float GetACMR(const std::vector<uint32_t>& indices, int cacheSize)
+{
+    std::vector<uint32_t> cache;
+    int misses = 0;
+    for (uint32_t v : indices) {
+        if (std::find(cache.begin(), cache.end(), v) != cache.end()) continue;
+        misses++;
+        cache.push_back(v);
+        if ((int)cache.size() > cacheSize) cache.erase(cache.begin());
+    }
+    return indices.empty() ? 0.0f : misses / (indices.size() / 3.0f);
+}
+
+int16_t QuantizeSnorm16(float value) { return (int16_t)std::lround(std::min(1.0f, std::max(-1.0f, value)) * 32767.0f); }
+int8_t QuantizeSnorm8(float value) { return (int8_t)std::lround(std::min(1.0f, std::max(-1.0f, value)) * 127.0f); }
+uint16_t QuantizeUnorm16(float value) { return (uint16_t)std::lround(std::min(1.0f, std::max(0.0f, value)) * 65535.0f); }
+
+size_t Align(size_t offset, size_t alignment) { return (offset + alignment - 1) / alignment * alignment; }
+
+int main(int argc, char** argv)
+{
+    if (argc < 3) {
+        std::cout << "Usage: mesh_convert <in.obj> <out.lkgm> [--lods <1-8>] [--cache-size <vertices>]\n";
+        return 2;
+    }
+
+    int lods = 4;
+    int cacheSize = 16;             // Post-transform cache entries, VideoCore VI reuses about this many
+    for (int i = 3; i < argc; i++) {
+        std::string arg(argv[i]);
+        if (arg == "--lods" && i + 1 < argc)
+            lods = std::min(MESH_FILE_MAX_LODS, std::max(1, std::stoi(argv[++i])));
+        else if (arg == "--cache-size" && i + 1 < argc)
+            cacheSize = std::max(3, std::stoi(argv[++i]));
+        else
+            std::cout << "WARNING: Unknown option '" << arg << "'\n";
+    }
+
+    MeshData source;
+    if (!LoadOBJ(argv[1], source)) {
+        std::cout << "FAIL: Couldn't load " << argv[1] << "\n";
+        return 2;
+    }
+
+    float min[3] = { INFINITY, INFINITY, INFINITY }, max[3] = { -INFINITY, -INFINITY, -INFINITY };
+    for (const Vertex& vertex : source.vertices) {
+        for (int k = 0; k < 3; k++) {
+            min[k] = std::min(min[k], vertex.position[k]);
+            max[k] = std::max(max[k], vertex.position[k]);
+        }
+    }
+    MeshFileHeader header = {};
+    memcpy(header.magic, "LKGM", 4);
+    header.version = MESH_FILE_VERSION;
+    header.vertexStride = sizeof(PackedVertex);
+    for (int k = 0; k < 3; k++) {
+        header.center[k] = (min[k] + max[k]) * 0.5f;
+        header.extent = std::max(header.extent, (max[k] - min[k]) * 0.5f);
+    }
+    if (header.extent <= 0.0f) header.extent = 1.0f;
+
+    // Each LOD halves the triangles of the one before: the finest clustering grid that gets there.
+    // Stops early once clustering can't reduce the mesh much anymore
+    std::vector<MeshData> meshes = { source };
+    for (int lod = 1; lod < lods; lod++) {
+        size_t target = meshes.back().indices.size() / 6;
+        int low = 1, high = 1024;
+        MeshData best;
+        while (low <= high) {
+            int grid = (low + high) / 2;
+            MeshData clustered = Cluster(source, grid, header.center, header.extent);
+            if (clustered.indices.size() / 3 <= target) {
+                best = clustered;
+                low = grid + 1;
+            } else {
+                high = grid - 1;
+            }
+        }
+        if (best.indices.size() < 3*4) break;
+        meshes.push_back(best);
+    }
+
+    std::vector<MeshFileLOD> table(meshes.size());
+    header.lodCount = meshes.size();
+    header.radius = 0.0f;
+    size_t offset = sizeof(MeshFileHeader) + table.size()*sizeof(MeshFileLOD);
+    std::vector<std::vector<PackedVertex>> vertexData(meshes.size());
+    std::vector<std::vector<unsigned char>> indexData(meshes.size());
+    for (size_t lod = 0; lod < meshes.size(); lod++) {
+        MeshData& mesh = meshes[lod];
+        float before = GetACMR(mesh.indices, cacheSize);
+        mesh.indices = Tipsify(mesh.indices, mesh.vertices.size(), cacheSize);
+        OptimizeVertexOrder(mesh);
+
+        for (const Vertex& vertex : mesh.vertices) {
+            PackedVertex packed = { };
+            float length = 0.0f;
+            for (int k = 0; k < 3; k++) {
+                packed.position[k] = QuantizeSnorm16((vertex.position[k] - header.center[k]) / header.extent);
+                length += (packed.position[k] / 32767.0f) * (packed.position[k] / 32767.0f);
+                packed.normal[k] = QuantizeSnorm8(vertex.normal[k]);
+            }
+            for (int k = 0; k < 2; k++) packed.texcoord[k] = QuantizeUnorm16(vertex.texcoord[k]);
+            header.radius = std::max(header.radius, std::sqrt(length));
+            vertexData[lod].push_back(packed);
+        }
+
+        MeshFileLOD& entry = table[lod];
+        entry.vertexCount = mesh.vertices.size();
+        entry.indexCount = mesh.indices.size();
+        entry.indexSize = mesh.vertices.size() <= 65535 ? 2 : 4;
+        entry.detail = (float)mesh.indices.size() / meshes[0].indices.size();
+        for (uint32_t index : mesh.indices) {
+            const unsigned char* bytes = (const unsigned char*)&index;
+            if (entry.indexSize == 2) {
+                uint16_t index16 = index;
+                bytes = (const unsigned char*)&index16;
+                indexData[lod].insert(indexData[lod].end(), bytes, bytes + 2);
+            } else {
+                indexData[lod].insert(indexData[lod].end(), bytes, bytes + 4);
+            }
+        }
+
+        offset = Align(offset, 16);
+        entry.vertexOffset = offset;
+        offset += vertexData[lod].size()*sizeof(PackedVertex);
+        offset = Align(offset, 16);
+        entry.indexOffset = offset;
+        offset += indexData[lod].size();
+
+        std::cout << "INFO: LOD " << lod << ": " << entry.vertexCount << " vertices, " << entry.indexCount / 3
+            << " triangles, " << entry.indexSize*8 << " bit indices, ACMR " << before << " -> "
+            << GetACMR(mesh.indices, cacheSize) << "\n";
+    }
+
+    std::ofstream file(argv[2], std::ios::binary | std::ios::trunc);
+    file.write((const char*)&header, sizeof(header));
+    file.write((const char*)table.data(), table.size()*sizeof(MeshFileLOD));
+    for (size_t lod = 0; lod < meshes.size(); lod++) {
+        // Zero padding up to the aligned offsets
+        while ((size_t)file.tellp() < table[lod].vertexOffset) file.put(0);
+        file.write((const char*)vertexData[lod].data(), vertexData[lod].size()*sizeof(PackedVertex));
+        while ((size_t)file.tellp() < table[lod].indexOffset) file.put(0);
+        file.write((const char*)indexData[lod].data(), indexData[lod].size());
+    }
+    if (!file) {
+        std::cout << "FAIL: Couldn't write " << argv[2] << "\n";
+        return 2;
+    }
+    std::cout << "INFO: Wrote " << argv[2] << " (" << offset << " bytes, " << meshes.size() << " LODs)\n";
+    return 0;
+}
@@ -0,0 +1,82 @@
+// Compares a headless dump (lkg_app --headless) against a golden image.
+// Usage: quilt_compare <golden.png> <test.png> [--tolerance <0-255>] [--max-fraction <0-1>] [--diff <out.png>]
+// A pixel differs when any channel is more than tolerance away from the golden one.
+// Exits with 0 when at most max-fraction of the pixels differ, 1 otherwise (2 on bad input).
+#include "raylib.h"
+
+#include <cmath>
+#include <string>
+#include <algorithm>
+#include <cstdlib>
+#include <iostream>
+
+int main(int argc, char** argv)
+{
+    if (argc < 3) {
+        std::cout << "Usage: quilt_compare <golden.png> <test.png> [--tolerance <0-255>] [--max-fraction <0-1>] [--diff <out.png>]\n";
+        return 2;
+    }
+
+    int tolerance = 2;              // Driver rounding differences
+    float maxFraction = 0.001f;
+    std::string diffPath;
+    for (int i = 3; i < argc; i++) {
+        std::string arg(argv[i]);
+        if (arg == "--tolerance" && i + 1 < argc)
+            tolerance = std::stoi(argv[++i]);
+        else if (arg == "--max-fraction" && i + 1 < argc)
+            maxFraction = std::stof(argv[++i]);
+        else if (arg == "--diff" && i + 1 < argc)
+            diffPath = argv[++i];
+        else
+            std::cout << "WARNING: Unknown option '" << arg << "'\n";
+    }
+
+    SetTraceLogLevel(LOG_WARNING);
+    Image golden = LoadImage(argv[1]);
+    Image test = LoadImage(argv[2]);
+    if (golden.data == NULL || test.data == NULL) {
+        std::cout << "FAIL: Couldn't load " << (golden.data == NULL ? argv[1] : argv[2]) << "\n";
+        return 2;
+    }
+    if (golden.width != test.width || golden.height != test.height) {
+        std::cout << "FAIL: Size " << test.width << "x" << test.height << " differs from golden "
+            << golden.width << "x" << golden.height << "\n";
+        return 1;
+    }
+
+    Color* a = LoadImageColors(golden);
+    Color* b = LoadImageColors(test);
+    int pixels = golden.width * golden.height;
+
+    // Differing pixels are red in the diff image, the rest a faded copy of the golden one
+    Image diff = GenImageColor(golden.width, golden.height, BLACK);
+    Color* d = (Color*)diff.data;
+
+    int differing = 0;
+    int maxError = 0;
+    for (int i = 0; i < pixels; i++) {
+        int error = std::max(std::max(std::abs(a[i].r - b[i].r), std::abs(a[i].g - b[i].g)),
+            std::max(std::abs(a[i].b - b[i].b), std::abs(a[i].a - b[i].a)));
+        maxError = std::max(maxError, error);
+        if (error > tolerance) {
+            differing++;
+            d[i] = RED;
+        } else {
+            d[i] = Color{ (unsigned char)(a[i].r / 4), (unsigned char)(a[i].g / 4), (unsigned char)(a[i].b / 4), 255 };
+        }
+    }
+    if (!diffPath.empty()) ExportImage(diff, diffPath.c_str());
+
+    float fraction = (float)differing / pixels;
+    bool pass = fraction <= maxFraction;
+    std::cout << (pass ? "PASS" : "FAIL") << ": " << differing << " of " << pixels << " pixels ("
+        << fraction * 100.0f << "%) differ by more than " << tolerance << ", max error " << maxError << "\n";
+
+    UnloadImageColors(a);
+    UnloadImageColors(b);
+    UnloadImage(diff);
+    UnloadImage(golden);
+    UnloadImage(test);
+    return pass ? 0 : 1;
+}
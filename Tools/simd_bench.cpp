@@ -0,0 +1,113 @@
+// Times the batch kernels of simd.h against the scalar raylib functions they replace, and checks they agree.
+// Usage: simd_bench [--count <elements>] [--repeat <n>]
+// Results have to be bit identical, so build it with -ffp-contract=off (CMakeLists.txt does).
+// Exits with 0 when every kernel agrees, 1 otherwise.
+#include "raylib.h"
+#include "raymath.h"
+
+#include <chrono>
+#include <cmath>
+#include <cstring>
+#include <string>
+#include <vector>
+#include <iomanip>
+#include <iostream>
+#include <algorithm>
+
+#include "../simd.h"
+
+typedef std::chrono::steady_clock Clock;
+
+// Elements whose bytes differ
+int CountMismatches(const void *a, const void *b, int count, size_t size)
+{
+    int mismatches = 0;
+    for (int i = 0; i < count; i++)
+        mismatches += memcmp((const char *)a + i*size, (const char *)b + i*size, size) != 0;
+    return mismatches;
+}
+
+// Best of repeat runs, in nanoseconds per element
+template <typename F>
+double Time(F run, int count, int repeat)
+{
+    double best = INFINITY;
+    for (int r = 0; r < repeat; r++) {
+        auto start = Clock::now();
+        run();
+        best = std::min(best, std::chrono::duration<double, std::nano>(Clock::now() - start).count() / count);
+    }
+    return best;
+}
+
+bool Report(const std::string& name, double scalar, double batch, int mismatches)
+{
+    bool agrees = mismatches == 0;
+    std::cout << std::left << std::setw(18) << name << std::right << std::fixed << std::setprecision(2)
+        << std::setw(10) << scalar << std::setw(10) << batch << std::setw(9) << scalar / batch << "x"
+        << std::setw(12) << mismatches << (agrees ? "" : "  FAIL") << "\n";
+    return agrees;
+}
+
+int main(int argc, char** argv)
+{
+    int count = 4096;       // About the lines and glyphs of a busy frame
+    int repeat = 200;
+    for (int i = 1; i < argc; i++) {
+        std::string arg(argv[i]);
+        if (arg == "--count" && i + 1 < argc)
+            count = std::max(1, std::stoi(argv[++i]));
+        else if (arg == "--repeat" && i + 1 < argc)
+            repeat = std::max(1, std::stoi(argv[++i]));
+        else
+            std::cout << "WARNING: Unknown option '" << arg << "'\n";
+    }
+
+    SetRandomSeed(0);
+    auto random = [] (float min, float max) { return min + (max - min) * GetRandomValue(0, 100000) / 100000.0f; };
+    Matrix transform = MatrixMultiply(MatrixMultiply(MatrixScale(0.5f, 1.8f, 2.2f), MatrixRotate(Vector3{ 1, 1, 1 }, 0.7f)),
+        MatrixTranslate(0.3f, -1.25f, 4.0f));
+
+    std::vector<Vector3> points(count);
+    std::vector<Matrix> matrices(count);
+    std::vector<Vector4> colors(count);
+    for (int i = 0; i < count; i++) {
+        points[i] = Vector3{ random(-5, 5), random(-5, 5), random(-5, 5) };
+        matrices[i] = MatrixMultiply(MatrixRotate(Vector3{ random(-1, 1), random(-1, 1), 1 }, random(0, PI)),
+            MatrixTranslate(random(-5, 5), random(-5, 5), random(-5, 5)));
+        colors[i] = Vector4{ random(0, 1), random(0, 1), random(0, 1), random(0, 1) };
+    }
+
+    std::cout << "INFO: " << GetSimdName() << " kernels, " << count << " elements, best of " << repeat << " runs\n";
+    std::cout << std::left << std::setw(18) << "kernel" << std::right << std::setw(10) << "scalar" << std::setw(10) << "batch"
+        << std::setw(10) << "speedup" << std::setw(12) << "mismatches" << "   (ns per element)\n";
+    bool agrees = true;
+
+    {
+        std::vector<Vector3> scalar(count), batch(count);
+        double scalarTime = Time([&] {
+            for (int i = 0; i < count; i++) scalar[i] = Vector3Transform(points[i], transform);
+        }, count, repeat);
+        double batchTime = Time([&] { TransformPoints(points.data(), count, transform, batch.data()); }, count, repeat);
+        agrees &= Report("TransformPoints", scalarTime, batchTime, CountMismatches(scalar.data(), batch.data(), count, sizeof(Vector3)));
+    }
+    {
+        std::vector<float16> scalar(count), batch(count);
+        double scalarTime = Time([&] {
+            for (int i = 0; i < count; i++) scalar[i] = MatrixToFloatV(MatrixMultiply(matrices[i], transform));
+        }, count, repeat);
+        double batchTime = Time([&] { MultiplyMatrices(matrices.data(), count, transform, batch.data()); }, count, repeat);
+        agrees &= Report("MultiplyMatrices", scalarTime, batchTime, CountMismatches(scalar.data(), batch.data(), count, sizeof(float16)));
+    }
+    {
+        std::vector<Color> scalar(count), batch(count);
+        double scalarTime = Time([&] {
+            for (int i = 0; i < count; i++) scalar[i] = ColorFromNormalized(colors[i]);
+        }, count, repeat);
+        double batchTime = Time([&] { PackColors(colors.data(), count, batch.data()); }, count, repeat);
+        agrees &= Report("PackColors", scalarTime, batchTime, CountMismatches(scalar.data(), batch.data(), count, sizeof(Color)));
+    }
+
+    if (!agrees) std::cout << "FAIL: Batch results differ from the scalar ones\n";
+    return agrees ? 0 : 1;
+}
@@ -0,0 +1,276 @@
+#include "raylib.h"
+#include "raymath.h"
+#include "rlgl.h"
+
+#include <cmath>
+#include <ctime>
+#include <stdlib.h>
+#include <string>
+#include <vector>
+#include <sstream>
+#include <iostream>
+#include <fstream>
+
+#include "config.h"
+#include "raylib_extensions.h"
+#include "renderer.h"
+#include "profiler.h"
+#include "headless.h"
+#include "sceneclock.h"
+
+#include "scenes.h"
+
+// Scene benchmark: renders every scene at every quilt configuration below for a fixed number of
+// frames and writes the per configuration costs as JSON and/or CSV, so runs can be diffed between
+// commits and machines. Scenes are updated from a manual time source, so every run steps them identically.
+
+const std::vector<std::pair<int, int>> BENCH_TILE_RESOLUTIONS = { {168, 224}, {252, 336}, {315, 420}, {420, 560} };
+const std::vector<std::pair<int, int>> BENCH_TILES = { {8, 6}, {6, 4} };
+const std::vector<std::string> BENCH_STRESS_SCENES = { "stress2000", "stress10000", "field100000" };
+
+struct BenchOptions {
+    int frames = 120;       // Measured frames per configuration
+    int warmup = 10;        // Frames rendered before measuring (shader compiles, buffer growth)
+    bool window = false;    // Render into a window instead of an offscreen context
+    std::vector<std::string> scenes;
+    std::string jsonPath;
+    std::string csvPath;
+    std::vector<char*> appArgs; // Everything else, parsed as AppOptions
+
+    BenchOptions(int argc, char** argv) {
+        appArgs.push_back(argv[0]);
+        for (int i = 1; i < argc; i++) {
+            std::string arg(argv[i]);
+            if (arg == "--frames" && i + 1 < argc)
+                this->frames = std::max(1, std::stoi(argv[++i]));
+            else if (arg == "--warmup" && i + 1 < argc)
+                this->warmup = std::max(0, std::stoi(argv[++i]));
+            else if (arg == "--window")
+                this->window = true;
+            else if (arg == "--scenes" && i + 1 < argc) {
+                std::stringstream list(argv[++i]);
+                std::string name;
+                while (std::getline(list, name, ','))
+                    if (!name.empty()) this->scenes.push_back(name);
+            }
+            else if (arg == "--json" && i + 1 < argc)
+                this->jsonPath = argv[++i];
+            else if (arg == "--csv" && i + 1 < argc)
+                this->csvPath = argv[++i];
+            else
+                this->appArgs.push_back(argv[i]);
+        }
+
+        if (this->scenes.empty()) {
+            this->scenes = SCENE_NAMES;
+            this->scenes.insert(this->scenes.end(), BENCH_STRESS_SCENES.begin(), BENCH_STRESS_SCENES.end());
+        }
+    }
+};
+
+struct BenchResult {
+    std::string scene;
+    std::pair<int, int> tiles;
+    std::pair<int, int> tileRes;
+    int frames;
+    ProfileStats frame;         // Milliseconds
+    ProfileStats cpuPerView;    // Build + upload + quilt CPU milliseconds, divided by the view count
+    ProfileStats gpuQuilt;      // Milliseconds
+    ProfileStats gpuInterleave; // Milliseconds
+    bool gpuFenced;             // No timer queries, GPU times are upper bounds
+    ProfileStats drawCalls;
+    ProfileStats instances;
+    ProfileStats culled;        // Instances outside every view
+    ProfileStats uploadBytes;
+    long arenaHighWater;        // Bytes of frame arena a frame used at most
+    int arenaBlocks;            // Allocated by the frame arena during measured frames, 0 in steady state
+};
+
+BenchResult RunBench(const std::string& sceneName, std::pair<int, int> tiles, std::pair<int, int> tileRes,
+        const BenchOptions& bench, const AppOptions& options, const LKGConfig& config,
+        RenderTexture2D output, FrameProfiler& profiler) {
+    BenchResult result = { sceneName, tiles, tileRes, bench.frames };
+
+    SetRandomSeed(0);
+    Scene* scene = CreateScene(sceneName);
+    rlEnableBackfaceCulling();
+    scene->Activate();
+    // Measure the scene as shown, not with placeholder textures
+    resources.FinishLoading();
+    QuiltRenderer* renderer = new QuiltRenderer(scene, options, config, output.texture.width, output.texture.height, profiler);
+    renderer->SetQuality(tiles, tileRes);
+
+    // Frames are a fixed 60th of a second apart, the same updates run on every machine
+    ManualTimeSource timeSource;
+    SceneClock sceneClock(&timeSource, options.tickRate);
+    for (int frame = 0; frame < bench.warmup + bench.frames; frame++) {
+        if (frame == bench.warmup) profiler.Reset();
+
+        profiler.BeginFrame();
+        timeSource.Advance(1.0/60.0);
+        {
+            ProfileScope scope(profiler, ProfileStage::Update);
+            int steps = sceneClock.Advance();
+            for (int i = 0; i < steps; i++) scene->Update(sceneClock.GetStep());
+        }
+        renderer->RenderQuilt(sceneClock.GetRenderTime(), sceneClock.GetAlpha());
+        BeginTextureMode(output);
+            ClearBackground(RAYWHITE);
+            renderer->Interleave();
+        EndTextureMode();
+        profiler.EndFrame();
+    }
+    // Timer queries of the last frames are still in flight, wait for the GPU so they don't leak into the next run
+    rlDrawRenderBatchActive();
+    glFinish();
+
+    int views = tiles.first * tiles.second;
+    ProfileStats build = profiler.GetCpuStats(ProfileStage::Build);
+    ProfileStats upload = profiler.GetCpuStats(ProfileStage::Upload);
+    ProfileStats quilt = profiler.GetCpuStats(ProfileStage::Quilt);
+    // Sum of the parts' stats, not the stats of the sum, close enough to compare runs
+    result.cpuPerView = ProfileStats{ (build.min + upload.min + quilt.min) / views,
+        (build.avg + upload.avg + quilt.avg) / views, (build.p99 + upload.p99 + quilt.p99) / views };
+    result.frame = profiler.GetFrameStats();
+    result.gpuQuilt = profiler.GetGpuStats(ProfileStage::Quilt);
+    result.gpuInterleave = profiler.GetGpuStats(ProfileStage::Interleave);
+    result.gpuFenced = !profiler.HasTimerQueries();
+    result.drawCalls = profiler.GetDrawCallStats();
+    result.instances = profiler.GetInstanceStats();
+    result.culled = profiler.GetCulledStats();
+    result.uploadBytes = profiler.GetUploadStats();
+    result.arenaHighWater = profiler.GetArenaHighWater();
+    result.arenaBlocks = profiler.GetArenaBlocksAllocated();
+
+    delete renderer;
+    delete scene;
+    // Freed VBO and shader ids get reused by the next scene, its streams must not find these
+    UnloadInstanceStreams();
+
+    std::cout << "INFO: " << sceneName << " " << tiles.first << "x" << tiles.second << " @ "
+        << tileRes.first << "x" << tileRes.second << ": " << TextFormat("%.2f", result.frame.avg) << " ms/frame, "
+        << TextFormat("%.3f", result.cpuPerView.avg) << " CPU ms/view, "
+        << TextFormat("%.2f", result.gpuQuilt.avg) << " GPU ms/quilt\n";
+    return result;
+}
+
+// JSON ----------
+std::string StatsJson(ProfileStats stats) {
+    return TextFormat("{\"min\": %.4f, \"avg\": %.4f, \"p99\": %.4f}", stats.min, stats.avg, stats.p99);
+}
+
+void WriteJson(std::ostream& out, const std::vector<BenchResult>& results) {
+    out << "[\n";
+    for (size_t i = 0; i < results.size(); i++) {
+        const BenchResult& r = results[i];
+        out << "  {\"scene\": \"" << r.scene << "\""
+            << ", \"tiles\": [" << r.tiles.first << ", " << r.tiles.second << "]"
+            << ", \"tile_resolution\": [" << r.tileRes.first << ", " << r.tileRes.second << "]"
+            << ", \"frames\": " << r.frames
+            << ",\n   \"frame_ms\": " << StatsJson(r.frame)
+            << ",\n   \"cpu_ms_per_view\": " << StatsJson(r.cpuPerView)
+            << ",\n   \"gpu_quilt_ms\": " << StatsJson(r.gpuQuilt)
+            << ",\n   \"gpu_interleave_ms\": " << StatsJson(r.gpuInterleave)
+            << ",\n   \"gpu_fenced\": " << (r.gpuFenced ? "true" : "false")
+            << ",\n   \"draw_calls\": " << StatsJson(r.drawCalls)
+            << ",\n   \"instances\": " << StatsJson(r.instances)
+            << ",\n   \"culled\": " << StatsJson(r.culled)
+            << ",\n   \"upload_bytes\": " << StatsJson(r.uploadBytes)
+            << ",\n   \"arena_high_water_bytes\": " << r.arenaHighWater
+            << ", \"arena_blocks_allocated\": " << r.arenaBlocks
+            << "}" << (i + 1 < results.size() ? "," : "") << "\n";
+    }
+    out << "]\n";
+}
+
+// CSV ----------
+void WriteCsv(std::ostream& out, const std::vector<BenchResult>& results) {
+    out << "scene,tiles_x,tiles_y,tile_width,tile_height,frames,"
+        << "frame_ms_avg,frame_ms_p99,cpu_ms_per_view_avg,cpu_ms_per_view_p99,"
+        << "gpu_quilt_ms_avg,gpu_quilt_ms_p99,gpu_interleave_ms_avg,gpu_fenced,"
+        << "draw_calls_avg,instances_avg,culled_avg,upload_bytes_avg,arena_high_water_bytes,arena_blocks_allocated\n";
+    for (const BenchResult& r : results) {
+        out << r.scene << "," << r.tiles.first << "," << r.tiles.second << ","
+            << r.tileRes.first << "," << r.tileRes.second << "," << r.frames << ","
+            << TextFormat("%.4f,%.4f,%.4f,%.4f,%.4f,%.4f,%.4f,", r.frame.avg, r.frame.p99,
+                r.cpuPerView.avg, r.cpuPerView.p99, r.gpuQuilt.avg, r.gpuQuilt.p99, r.gpuInterleave.avg)
+            << (r.gpuFenced ? 1 : 0) << ","
+            << TextFormat("%.1f,%.1f,%.1f,%.0f,", r.drawCalls.avg, r.instances.avg, r.culled.avg, r.uploadBytes.avg)
+            << r.arenaHighWater << "," << r.arenaBlocks << "\n";
+    }
+}
+
+int main(int argc, char** argv)
+{
+    BenchOptions bench(argc, argv);
+    AppOptions options((int)bench.appArgs.size(), bench.appArgs.data());
+    // Every frame has to be rendered to be measured
+    options.idle = false;
+
+    const int screenWidth = 1536;
+    const int screenHeight = 2048;
+
+    HeadlessContext* headless = NULL;
+    if (bench.window) {
+        InitWindow(screenWidth, screenHeight, "LKG Benchmark");
+    } else {
+        headless = new HeadlessContext();
+        if (!headless->Init(screenWidth, screenHeight)) return 1;
+    }
+
+    // Same wall clock on every run
+    setenv("TZ", "UTC", 1);
+    tzset();
+    fixedWallTime = 1000000000;
+
+    // Fix Rectangle UVs (See: https://github.com/raysan5/raylib/issues/1730)
+    Texture2D texture = { rlGetTextureIdDefault(), 1, 1, 1, PIXELFORMAT_UNCOMPRESSED_R8G8B8A8 };
+    SetShapesTexture(texture, Rectangle{ 0.0f, 0.0f, 1.0f, 1.0f });
+
+    shaderCache.SetDirectory(options.shaderCache);
+    if (options.multiview) InitMultiview();
+
+    std::ifstream config_file("display.cfg");
+    LKGConfig config(config_file);
+
+    // Stats over every measured frame, not the overlay's last 120
+    FrameProfiler* profiler = new FrameProfiler(bench.frames);
+    profiler->SetEnabled(true);
+    // Measured runs, GPU times are worth the stalls
+    profiler->SetGpuFencing(true);
+    RenderTexture2D output = LoadRenderTexture(screenWidth, screenHeight);
+
+    std::vector<BenchResult> results;
+    for (const std::string& sceneName : bench.scenes) {
+        if (!IsSceneName(sceneName)) {
+            std::cout << "WARNING: Unknown scene '" << sceneName << "', skipping\n";
+            continue;
+        }
+        for (std::pair<int, int> tiles : BENCH_TILES) {
+            for (std::pair<int, int> tileRes : BENCH_TILE_RESOLUTIONS) {
+                results.push_back(RunBench(sceneName, tiles, tileRes, bench, options, config, output, *profiler));
+            }
+        }
+    }
+
+    if (!bench.jsonPath.empty()) {
+        std::ofstream json(bench.jsonPath);
+        WriteJson(json, results);
+        std::cout << "INFO: Wrote " << bench.jsonPath << "\n";
+    }
+    if (!bench.csvPath.empty()) {
+        std::ofstream csv(bench.csvPath);
+        WriteCsv(csv, results);
+        std::cout << "INFO: Wrote " << bench.csvPath << "\n";
+    }
+    if (bench.jsonPath.empty() && bench.csvPath.empty()) WriteJson(std::cout, results);
+
+    UnloadRenderTexture(output);
+    resources.Unload();
+    delete profiler;
+    if (options.multiview) UnloadMultiview();
+    if (headless != NULL) delete headless;
+    else CloseWindow();
+
+    return 0;
+}
@@ -11,105 +11,87 @@
 
 #include "scene.h"
 #include "raylib_extensions.h"
+#include "resources.h"
+#include "scenegraph.h"
 
 class ClockScene : public Scene
 {
 private:
     Shader litShader;
     Material litMaterial;
+    Shader shadowShader;
+    ShadowPass shadow;
 
     Mesh cubeMesh;
+
+    // TRANSFORMS (see SceneGraph)
+    SceneGraph transforms;
+    SceneNode centerNode;
+    SceneNode handPivots[3];    // Seconds, minutes, hours
+    SceneNode handNodes[3];
+    SceneNode tickNodes[12];
+    const Color HAND_COLORS[3] = { RED, DARKGRAY, DARKGRAY };
 public:
     ClockScene() {
         std::cout << "[INITIALIZING SCENE]: Clock" << std::endl;
 
-        litShader = LoadShaderSingleFile("./Shaders/lit_instanced.shader"); // Lit shader
-        litShader.locs[SHADER_LOC_MATRIX_MODEL] = GetShaderLocationAttrib(litShader, "matModel");
-        litShader.locs[SHADER_LOC_COLOR_DIFFUSE] = GetShaderLocationAttrib(litShader, "colDiffuse");
-        litShader.locs[SHADER_LOC_MATRIX_VIEW] = GetShaderLocation(litShader, "matView");
-        litShader.locs[SHADER_LOC_MATRIX_PROJECTION] = GetShaderLocation(litShader, "matProjection");
-
-        Vector3 shadowColor = Vector3{0.8f, 0.8f, 0.8f};
-        SetShaderValue(litShader, GetShaderLocation(litShader, "shadowColor"), &shadowColor, SHADER_UNIFORM_VEC3);
-        Vector3 lightPos = Vector3{0.0f, -3.0f, 22.0f};
-        SetShaderValue(litShader, GetShaderLocation(litShader, "lightPos"), &lightPos, SHADER_UNIFORM_VEC3);
-        float planeZ = -2.0f;
-        SetShaderValue(litShader, GetShaderLocation(litShader, "planeZ"), &planeZ, SHADER_UNIFORM_FLOAT);
-
+        litShader = resources.AcquireShader("./Shaders/lit_instanced.shader", "#define COMPACT_INSTANCE\n"); // Lit shader
         litMaterial = LoadMaterialDefault(); // Lit material
         litMaterial.shader = litShader;
 
-        cubeMesh = GenMeshCube(1.5f, 1.5f, 1.5f);
+        shadowShader = resources.AcquireShader("./Shaders/lit_instanced.shader", "#define COMPACT_INSTANCE\n#define SHADOW_PASS\n"); // Shadow shader
+        shadow.material = LoadMaterialDefault(); // Shadow material
+        shadow.material.shader = shadowShader;
+        shadow.plane = PlanarShadow{ Vector3{0.0f, -3.0f, 22.0f}, -2.0f };
+
+        cubeMesh = resources.AcquireMesh("cube 1.5", [] { return GenMeshCube(1.5f, 1.5f, 1.5f); });
         //cubeMesh = GenMeshPlaneY(1.5f, 1.5f, 1, 1);
+
+        // Hands turn around a pivot, each a scaled cube moved out from it (z keeps them apart)
+        centerNode = transforms.Create(NO_SCENE_NODE, Vector3{0, 0, -0.75f * 1.5f}, QuaternionIdentity(), Vector3{0.05f, 0.05f, 1.5f});
+        const Vector3 HAND_SCALES[3] = { {0.05f, 1.1f, 0.05f}, {0.05f, 1.1f, 0.05f}, {0.05f, 0.8f, 0.05f} };
+        const float HAND_DEPTHS[3] = { 0.0f, 1.5f, -1.5f };
+        for (int i = 0; i < 3; i++) {
+            handPivots[i] = transforms.Create();
+            handNodes[i] = transforms.Create(handPivots[i], Vector3{0, 0.6666f * HAND_SCALES[i].y, HAND_DEPTHS[i] * HAND_SCALES[i].z},
+                QuaternionIdentity(), HAND_SCALES[i]);
+        }
+        for (int i = 0; i < 12; i++) {
+            SceneNode pivot = transforms.Create(NO_SCENE_NODE, Vector3Zero(), QuaternionFromAxisAngle(Vector3{0, 0, 1}, (i/12.0f) * 2.0f * PI));
+            tickNodes[i] = transforms.Create(pivot, Vector3Zero(), QuaternionIdentity(), Vector3{0.1f, 0.1f, 0.1f});
+        }
     }
     ~ClockScene() {
-        UnloadShader(litShader);
+        resources.ReleaseShader(litShader);
+        resources.ReleaseShader(shadowShader);
+        resources.ReleaseMesh(cubeMesh);
+        UnloadMaterialMaps(litMaterial);
+        UnloadMaterialMaps(shadow.material);
     }
-    void Update() { }
-    void Draw() {
-        float gameTime = GetTime();// * 0.25f;
-        Vector3 position = {(float)sin(gameTime), (float)sin(gameTime * 2.0f) * 1.5f, -2.0f};
-        Vector3 position2 = {(float)sin(gameTime * 3.0f), (float)sin(gameTime * 1.5f) * 1.5f, -0.5f};
-
-        std::time_t now = time(nullptr);
+    void Activate() {
+        SetShadowPassUniforms(shadow, Vector3{0.8f, 0.8f, 0.8f});
+    }
+    void Update(float deltaTime) { }
+    bool SupportsThreadedUpdate() { return true; }
+    void Draw(DrawList& list, double time, float alpha) {
+        std::time_t now = GetWallTime();
         std::tm calender_time = *std::localtime( std::addressof(now) ) ;
 
-        Matrix transforms[500];
-        Vector4 colors[500];
-        int instanceIdx = 0;
-
-        auto drawCube = [&] (Matrix m, Color c) {
-            c.a = 0;
-            colors[instanceIdx] = ColorNormalize(c);
-            transforms[instanceIdx++] = m;
-            c.a = 255;
-            colors[instanceIdx] = ColorNormalize(c);
-            transforms[instanceIdx++] = m;
+        float handAngles[3] = {
+            fmodf((float)calender_time.tm_sec, 60.0f)/60.0f * -360.0f,
+            fmodf((float)calender_time.tm_min, 60.0f)/60.0f * -360.0f,
+            fmodf((float)(calender_time.tm_hour % 12), 12.0f)/12.0f * -360.0f,
         };
+        for (int i = 0; i < 3; i++) transforms.SetRotation(handPivots[i], Vector3{0, 0, 1}, handAngles[i]);
+        for (int i = 0; i < 12; i++) transforms.SetTranslation(tickNodes[i], Vector3{(19.0f + (float)sin(time * 3.0f + i)) * 0.1f, 0, 0});
+        // Tilted by the renderer like the matrix stack is (see QuiltRenderer::RenderQuilt)
+        transforms.SetBase(rlGetMatrixTransform());
+        transforms.Update();
 
-        //Cube
-        rlPushMatrix();
-            rlScalef(0.5f, 0.5f, 0.5f);
-            rlTranslatef(position.x * 2, position.y * 2, position.z);
-            //drawCube(rlGetMatrixTransform(), PINK);
-        rlPopMatrix();
-
-        rlPushMatrix();
-            rlScalef(0.05f, 0.05f, 1.5f);
-            rlTranslatef(0, 0, -0.75f);
-            drawCube(rlGetMatrixTransform(), BLACK);
-        rlPopMatrix();
-        
-        //Seconds
-        rlPushMatrix();
-            rlRotatef(fmod(calender_time.tm_sec, 60.0f)/60.0f * -360.0f, 0, 0, 1);
-            rlScalef(0.05f, 1.1f, 0.05f);
-            rlTranslatef(0, 0.6666f, 0);
-            drawCube(rlGetMatrixTransform(), RED);
-        rlPopMatrix();
-        //Minutes
-        rlPushMatrix();
-            rlRotatef(fmod(calender_time.tm_min, 60.0f)/60.0f * -360.0f, 0, 0, 1);
-            rlScalef(0.05f, 1.1f, 0.05f);
-            rlTranslatef(0, 0.6666f, 1.5f);
-            drawCube(rlGetMatrixTransform(), DARKGRAY);
-        rlPopMatrix();
-        //Hours
-        rlPushMatrix();
-            rlRotatef(fmod(calender_time.tm_hour % 12, 12.0f)/12.0f * -360.0f, 0, 0, 1);
-            rlScalef(0.05f, 0.8f, 0.05f);
-            rlTranslatef(0, 0.6666f, -1.5f);
-            drawCube(rlGetMatrixTransform(), DARKGRAY);
-        rlPopMatrix();
-
-        for (int i = 0; i < 12; i++) {
-            rlPushMatrix();
-                rlScalef(0.1f, 0.1f, 0.1f);
-                rlRotatef((i/12.0f) * 360.0f, 0, 0, 1);
-                rlTranslatef(19.0f + sin(GetTime() * 3.0f + i), 0, 0);
-                drawCube(rlGetMatrixTransform(), DARKGRAY);
-            rlPopMatrix();
-        }
-        DrawMeshInstancedC(cubeMesh, litMaterial, transforms, colors, instanceIdx);
+        InstanceBatch<CompactInstance> instances(list.GetArena(), 16);
+        instances.Push(ToCompactInstance(transforms.GetWorld(centerNode), BLACK));
+        for (int i = 0; i < 3; i++) instances.Push(ToCompactInstance(transforms.GetWorld(handNodes[i]), HAND_COLORS[i]));
+        for (int i = 0; i < 12; i++) instances.Push(ToCompactInstance(transforms.GetWorld(tickNodes[i]), DARKGRAY));
+        list.DrawInstances(cubeMesh, litMaterial, COMPACT_INSTANCE_LAYOUT, instances, &shadow);
     }
 };
@@ -1,3 +1,10 @@
+#ifndef CONFIG_H
+#define CONFIG_H
+
+#include <string>
+#include <iostream>
+#include <algorithm>
+
 struct LKGConfig {
     float pitch;
     float slope;
@@ -21,3 +28,105 @@ struct LKGConfig {
         config_file >> this->dpi;
     }
 };
+
+struct AppOptions {
+    bool multiview = false; // Submit each scene draw once for all views (see InitMultiview)
+    bool layered = false;   // Render views into a texture array instead of an atlas (see Quilt)
+    bool quiltDebug = false;// Show the quilt instead of the interleaved output
+    float governorFPS = 0;  // Adapt quilt quality to hold this frame rate, 0 disables (see QualityGovernor)
+    std::string thermalPath;// Temperature file the governor also watches, e.g. /sys/class/thermal/thermal_zone0/temp
+    float tickRate = 60;    // Fixed Scene::Update rate (see SceneClock)
+    float simulationRate = 0;// Run Scene::Update on its own thread at this rate, 0 updates on the render thread
+    bool idle = true;       // Skip the quilt pass and present at idleFPS while nothing changes
+    float idleFPS = 10;
+    int viewStride = 0;     // Override the scene's view stride, 0 keeps it (see ViewSynthesizer)
+    bool lut = false;       // Look up subpixel views in a baked texture (see Interleaver)
+    bool lutHighp = false;  // Run the interleaver at highp
+    bool lutCompare = false;// Highlight subpixels where the LUT and analytic views disagree
+    bool culling = true;    // Skip instances outside every view (see ViewConeCuller)
+    bool viewCulling = false;// Also cull per view, for large scenes (see InstanceBVH)
+    bool shadows = true;    // Draw planar shadow passes (see ShadowPass)
+    std::string scene = "clock";// See SCENE_NAMES
+    std::string shaderCache = "./ShaderCache";// Linked shader programs from earlier runs, empty compiles every shader (see ShaderCache)
+    float uploadBudget = 2; // Milliseconds per frame spent uploading loaded textures (see ResourceCache::UploadTextures)
+    bool gpuTiming = false; // Time GPU stages with fences when there are no timer queries (see FrameProfiler::SetGpuFencing)
+    int headlessFrames = 0; // Render this many frames offscreen and dump them instead of opening a window
+    double fixedTime = 0;   // Scene time (and wall clock offset) of headless frames
+    std::string dumpPrefix = "headless";
+
+    AppOptions(int argc, char** argv) {
+        for (int i = 1; i < argc; i++) {
+            std::string arg(argv[i]);
+            if (arg == "--multiview")
+                this->multiview = true;
+            else if (arg == "--layered")
+                this->layered = true;
+            else if (arg == "--quilt-debug")
+                this->quiltDebug = true;
+            else if (arg == "--lut")
+                this->lut = true;
+            else if (arg == "--lut-highp")
+                this->lut = this->lutHighp = true;
+            else if (arg == "--lut-compare")
+                this->lut = this->lutCompare = true;
+            else if (arg == "--tick-rate" && i + 1 < argc)
+                this->tickRate = std::max(1.0f, std::stof(argv[++i]));
+            else if (arg == "--sim-thread" && i + 1 < argc)
+                this->simulationRate = std::stof(argv[++i]);
+            else if (arg == "--no-idle")
+                this->idle = false;
+            else if (arg == "--idle-fps" && i + 1 < argc)
+                this->idleFPS = std::max(1.0f, std::stof(argv[++i]));
+            else if (arg == "--view-stride" && i + 1 < argc)
+                this->viewStride = std::max(1, std::stoi(argv[++i]));
+            else if (arg == "--no-cull")
+                this->culling = false;
+            else if (arg == "--cull-views")
+                this->viewCulling = true;
+            else if (arg == "--no-shadows")
+                this->shadows = false;
+            else if (arg == "--scene" && i + 1 < argc)
+                this->scene = argv[++i];
+            else if (arg == "--shader-cache" && i + 1 < argc)
+                this->shaderCache = argv[++i];
+            else if (arg == "--no-shader-cache")
+                this->shaderCache = "";
+            else if (arg == "--upload-budget" && i + 1 < argc)
+                this->uploadBudget = std::max(0.0f, std::stof(argv[++i]));
+            else if (arg == "--gpu-timing")
+                this->gpuTiming = true;
+            else if (arg == "--headless" && i + 1 < argc)
+                this->headlessFrames = std::max(1, std::stoi(argv[++i]));
+            else if (arg == "--time" && i + 1 < argc)
+                this->fixedTime = std::stod(argv[++i]);
+            else if (arg == "--dump" && i + 1 < argc)
+                this->dumpPrefix = argv[++i];
+            else if (arg == "--governor" && i + 1 < argc)
+                this->governorFPS = std::stof(argv[++i]);
+            else if (arg == "--thermal" && i + 1 < argc)
+                this->thermalPath = argv[++i];
+            else
+                std::cout << "WARNING: Unknown option '" << arg << "'\n";
+        }
+
+        // Multiview draws every view into one framebuffer, so it needs the atlas
+        if (this->multiview && this->layered) {
+            std::cout << "WARNING: --multiview requires the atlas quilt, ignoring --layered\n";
+            this->layered = false;
+        }
+
+        if (this->viewCulling && (this->multiview || !this->culling)) {
+            std::cout << "WARNING: --cull-views needs culling and a pass per view, ignoring it\n";
+            this->viewCulling = false;
+        }
+
+        if (this->gpuTiming && this->governorFPS > 0)
+            std::cout << "WARNING: --gpu-timing stalls every frame without timer queries, the governor will lower quality for it\n";
+
+        // Every headless frame is rendered, they're there to be measured and compared
+        if (this->headlessFrames > 0)
+            this->idle = false;
+    }
+};
+
+#endif
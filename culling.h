@@ -0,0 +1,243 @@
+#ifndef CULLING_H
+#define CULLING_H
+
+#include "raylib.h"
+#include "raymath.h"
+
+#include <cmath>
+#include <vector>
+#include <utility>
+#include <algorithm>
+
+struct BoundingSphere {
+    Vector3 center;
+    float radius;
+};
+
+// Where lit_instanced's shadow pass draws an instance: projected from lightPos onto the plane
+// z = planeZ. The shadow can be on screen when the cube casting it isn't
+struct PlanarShadow {
+    Vector3 lightPos;
+    float planeZ;
+};
+
+BoundingSphere GetMeshBoundingSphere(Mesh mesh)
+{
+    BoundingBox box = GetMeshBoundingBox(mesh);
+    Vector3 center = Vector3Scale(Vector3Add(box.min, box.max), 0.5f);
+    return BoundingSphere{ center, Vector3Distance(center, box.max) };
+}
+
+BoundingSphere TransformBoundingSphere(BoundingSphere sphere, Matrix transform)
+{
+    // Largest axis scale of the transform
+    float scaleX = transform.m0*transform.m0 + transform.m1*transform.m1 + transform.m2*transform.m2;
+    float scaleY = transform.m4*transform.m4 + transform.m5*transform.m5 + transform.m6*transform.m6;
+    float scaleZ = transform.m8*transform.m8 + transform.m9*transform.m9 + transform.m10*transform.m10;
+    float scale = sqrtf(std::max(scaleX, std::max(scaleY, scaleZ)));
+
+    return BoundingSphere{ Vector3Transform(sphere.center, transform), sphere.radius * scale };
+}
+
+// Smallest sphere containing both
+BoundingSphere MergeBoundingSpheres(BoundingSphere a, BoundingSphere b)
+{
+    Vector3 offset = Vector3Subtract(b.center, a.center);
+    float distance = Vector3Length(offset);
+    if (distance + b.radius <= a.radius) return a;
+    if (distance + a.radius <= b.radius) return b;
+
+    float radius = (distance + a.radius + b.radius) * 0.5f;
+    return BoundingSphere{ Vector3Add(a.center, Vector3Scale(offset, (radius - a.radius) / distance)), radius };
+}
+
+// Conservative bound of the sphere's shadow: scaled by the point light's perspective and stretched by its slant
+BoundingSphere ProjectBoundingSphere(BoundingSphere sphere, PlanarShadow shadow)
+{
+    Vector3 toLight = Vector3Subtract(shadow.lightPos, sphere.center);
+    float height = toLight.z - sphere.radius;
+    if (height <= 0.0f) return BoundingSphere{ sphere.center, INFINITY };
+
+    float t = (shadow.planeZ - sphere.center.z) / toLight.z;
+    Vector3 center = Vector3Add(sphere.center, Vector3Scale(toLight, t));
+    float radius = sphere.radius * (shadow.lightPos.z - shadow.planeZ) / height * Vector3Length(toLight) / toLight.z;
+    return BoundingSphere{ center, radius };
+}
+
+// FRUSTUM ----------
+// Planes point inwards: dot(normal, p) + distance >= 0 inside
+struct Plane {
+    Vector3 normal;
+    float distance;
+};
+
+struct Frustum {
+    Plane planes[6];    // Left, right, bottom, top, near, far
+
+    // From a combined view-projection matrix (Gribb/Hartmann), raylib matrices have rows m0 m4 m8 m12 etc.
+    static Frustum FromMatrix(Matrix m) {
+        float rows[4][4] = {
+            { m.m0, m.m4, m.m8, m.m12 },
+            { m.m1, m.m5, m.m9, m.m13 },
+            { m.m2, m.m6, m.m10, m.m14 },
+            { m.m3, m.m7, m.m11, m.m15 },
+        };
+        Frustum frustum;
+        for (int i = 0; i < 6; i++) {
+            float sign = (i % 2 == 0) ? 1.0f : -1.0f;
+            const float* row = rows[i / 2];
+            Vector3 normal = { rows[3][0] + sign*row[0], rows[3][1] + sign*row[1], rows[3][2] + sign*row[2] };
+            float length = Vector3Length(normal);
+            frustum.planes[i] = Plane{ Vector3Scale(normal, 1.0f/length), (rows[3][3] + sign*row[3]) / length };
+        }
+        return frustum;
+    }
+
+    float Distance(int plane, Vector3 point) const {
+        return Vector3DotProduct(planes[plane].normal, point) + planes[plane].distance;
+    }
+    bool IsSphereOutside(int plane, BoundingSphere sphere) const {
+        return Distance(plane, sphere.center) < -sphere.radius;
+    }
+
+    // -1 outside, 0 intersecting, 1 inside
+    int TestBox(Vector3 min, Vector3 max) const {
+        int result = 1;
+        for (int i = 0; i < 6; i++) {
+            const Vector3& n = planes[i].normal;
+            // Corners furthest along and against the normal
+            Vector3 positive = { n.x >= 0 ? max.x : min.x, n.y >= 0 ? max.y : min.y, n.z >= 0 ? max.z : min.z };
+            Vector3 negative = { n.x >= 0 ? min.x : max.x, n.y >= 0 ? min.y : max.y, n.z >= 0 ? min.z : max.z };
+            if (Distance(i, positive) < 0) return -1;
+            if (Distance(i, negative) < 0) result = 0;
+        }
+        return result;
+    }
+};
+
+// Union of every view's frustum. Views only differ by the camera's x offset along the baseline (and the
+// matching off-axis shift, see frustumMatrixOffAxis), so the top, bottom, near and far planes are shared
+// and the signed distance to a side plane is affine in the offset: a point outside a side plane of both
+// outermost views is outside it for every view in between. Testing the two outermost views is exact.
+class ViewConeCuller {
+private:
+    Frustum first;
+    Frustum last;
+public:
+    ViewConeCuller() { }
+    ViewConeCuller(Matrix firstViewProjection, Matrix lastViewProjection)
+        : first(Frustum::FromMatrix(firstViewProjection)), last(Frustum::FromMatrix(lastViewProjection)) { }
+
+    bool IsVisible(BoundingSphere sphere) const {
+        for (int i = 0; i < 6; i++) {
+            if (first.IsSphereOutside(i, sphere) && last.IsSphereOutside(i, sphere)) return false;
+        }
+        return true;
+    }
+};
+
+// BVH ----------
+// Per view refinement for commands with many instances. Instances are sorted along a Morton curve so
+// every node covers a contiguous range, a view then draws only the ranges of nodes inside its frustum.
+// Built from scratch every frame, which is linear apart from the sort.
+class InstanceBVH {
+private:
+    static const int LEAF_SIZE = 64;
+
+    struct Node {
+        Vector3 min;
+        Vector3 max;
+        int first;
+        int count;
+        int children[2];    // -1 for leaves
+    };
+    std::vector<Node> nodes;
+    std::vector<std::pair<unsigned int, int>> codes;
+
+    // 10 bits per axis, interleaved
+    static unsigned int SpreadBits(unsigned int v) {
+        v = (v * 0x00010001u) & 0xFF0000FFu;
+        v = (v * 0x00000101u) & 0x0F00F00Fu;
+        v = (v * 0x00000011u) & 0xC30C30C3u;
+        v = (v * 0x00000005u) & 0x49249249u;
+        return v;
+    }
+public:
+    // Fills order with the instance order the ranges refer to
+    void Build(const BoundingSphere* spheres, int count, std::vector<int>& order) {
+        nodes.clear();
+        order.resize(count);
+        if (count == 0) return;
+
+        Vector3 min = spheres[0].center;
+        Vector3 max = spheres[0].center;
+        for (int i = 1; i < count; i++) {
+            min = Vector3Min(min, spheres[i].center);
+            max = Vector3Max(max, spheres[i].center);
+        }
+        Vector3 extent = Vector3Subtract(max, min);
+        Vector3 scale = { extent.x > 0 ? 1023.0f/extent.x : 0, extent.y > 0 ? 1023.0f/extent.y : 0, extent.z > 0 ? 1023.0f/extent.z : 0 };
+
+        codes.resize(count);
+        for (int i = 0; i < count; i++) {
+            Vector3 p = Vector3Subtract(spheres[i].center, min);
+            codes[i] = std::make_pair(SpreadBits((unsigned int)(p.x * scale.x)) << 2
+                | SpreadBits((unsigned int)(p.y * scale.y)) << 1 | SpreadBits((unsigned int)(p.z * scale.z)), i);
+        }
+        std::sort(codes.begin(), codes.end());
+        for (int i = 0; i < count; i++) order[i] = codes[i].second;
+
+        // Leaves, then pairs of nodes up to the root
+        for (int first = 0; first < count; first += LEAF_SIZE) {
+            Node leaf = { { INFINITY, INFINITY, INFINITY }, { -INFINITY, -INFINITY, -INFINITY }, first,
+                std::min(LEAF_SIZE, count - first), { -1, -1 } };
+            for (int i = first; i < first + leaf.count; i++) {
+                const BoundingSphere& sphere = spheres[order[i]];
+                Vector3 radius = { sphere.radius, sphere.radius, sphere.radius };
+                leaf.min = Vector3Min(leaf.min, Vector3Subtract(sphere.center, radius));
+                leaf.max = Vector3Max(leaf.max, Vector3Add(sphere.center, radius));
+            }
+            nodes.push_back(leaf);
+        }
+        int levelStart = 0;
+        int levelEnd = nodes.size();
+        while (levelEnd - levelStart > 1) {
+            for (int i = levelStart; i < levelEnd; i += 2) {
+                if (i + 1 == levelEnd) {
+                    nodes.push_back(nodes[i]);
+                    continue;
+                }
+                const Node& a = nodes[i];
+                const Node& b = nodes[i + 1];
+                nodes.push_back(Node{ Vector3Min(a.min, b.min), Vector3Max(a.max, b.max), a.first, a.count + b.count, { i, i + 1 } });
+            }
+            levelStart = levelEnd;
+            levelEnd = nodes.size();
+        }
+    }
+
+    // Append the (first, count) ranges visible in the frustum, in order and merged
+    void Query(const Frustum& frustum, std::vector<std::pair<int, int>>& ranges) const {
+        if (nodes.empty()) return;
+
+        int stack[64];
+        int depth = 0;
+        stack[depth++] = nodes.size() - 1;
+        while (depth > 0) {
+            const Node& node = nodes[stack[--depth]];
+            int test = frustum.TestBox(node.min, node.max);
+            if (test < 0) continue;
+            if (test == 0 && node.children[0] != -1) {
+                stack[depth++] = node.children[1];
+                stack[depth++] = node.children[0];
+                continue;
+            }
+            if (!ranges.empty() && ranges.back().first + ranges.back().second == node.first)
+                ranges.back().second += node.count;
+            else
+                ranges.push_back(std::make_pair(node.first, node.count));
+        }
+    }
+};
+
+#endif
@@ -0,0 +1,247 @@
+#ifndef DRAWLIST_H
+#define DRAWLIST_H
+
+#include <map>
+#include <vector>
+#include <cstring>
+
+#include "raylib_extensions.h"
+#include "culling.h"
+#include "framearena.h"
+
+// Planar shadows of a draw's instances (see PlanarShadow), drawn as a second pass over the same instance buffer
+struct ShadowPass {
+    Material material;  // Usually Shaders/lit_instanced.shader compiled with SHADOW_PASS
+    PlanarShadow plane;
+};
+
+// Point lit_instanced's shadow pass at the plane. Its shader is shared between scenes, call from Scene::Activate
+void SetShadowPassUniforms(const ShadowPass& shadow, Vector3 color)
+{
+    Shader shader = shadow.material.shader;
+    SetShaderValue(shader, GetShaderLocation(shader, "shadowColor"), &color, SHADER_UNIFORM_VEC3);
+    SetShaderValue(shader, GetShaderLocation(shader, "lightPos"), &shadow.plane.lightPos, SHADER_UNIFORM_VEC3);
+    SetShaderValue(shader, GetShaderLocation(shader, "planeZ"), &shadow.plane.planeZ, SHADER_UNIFORM_FLOAT);
+}
+
+// A frame's instanced draws, built once by Scene::Draw and replayed for every view.
+// Replaying only picks up the current view/projection matrices (see BeginMode3DLG).
+class DrawList {
+private:
+    struct Command {
+        Mesh mesh;
+        Material material;
+        const InstanceLayout* layout;
+        size_t offset;      // Into data, in bytes
+        int count;
+        InstanceStream *stream;
+        bool hasShadow;
+        ShadowPass shadow;
+        int boundsFirst;    // Into bounds, after Cull
+        int bvh;            // Index into bvhs, -1 draws every instance in every view
+    };
+
+    // Storage is kept between frames, so steady state frames don't allocate
+    std::vector<Command> commands;
+    std::vector<unsigned char> data;    // Instances of every command, each in its layout
+    std::vector<ModelInstance> staging;
+    int instanceCount = 0;
+    bool shadows = true;
+    std::pair<int, int> tileResolution = { 0, 0 };
+    FrameArena arena;
+
+    // Culling
+    std::map<unsigned int, BoundingSphere> meshBounds;  // By mesh VBO
+    std::vector<BoundingSphere> bounds;                 // Per instance, after Cull
+    std::vector<InstanceBVH> bvhs;
+    int bvhCount = 0;
+    int culled = 0;
+    std::vector<int> order;
+    std::vector<unsigned char> reordered;
+    std::vector<std::pair<int, int>> ranges;
+
+    BoundingSphere GetMeshBounds(Mesh mesh) {
+        auto it = meshBounds.find(mesh.vboId[0]);
+        if (it != meshBounds.end()) return it->second;
+        // Packed meshes keep no vertices on the CPU, their bounds come from the file
+        const PackedMeshFormat* packed = GetPackedMeshFormat(mesh);
+        if (packed != NULL) return meshBounds[mesh.vboId[0]] = BoundingSphere{ Vector3Zero(), packed->radius };
+        return meshBounds[mesh.vboId[0]] = GetMeshBoundingSphere(mesh);
+    }
+public:
+    void Clear() {
+        commands.clear();
+        data.clear();
+        instanceCount = 0;
+        bounds.clear();
+        bvhCount = 0;
+        culled = 0;
+    }
+    // Also forget what's cached per mesh, after the meshes of a previous scene were unloaded (their ids get reused)
+    void Reset() {
+        Clear();
+        meshBounds.clear();
+    }
+
+    // Skip every shadow pass, e.g. when the quality governor runs out of cheaper options
+    void SetShadowsEnabled(bool enabled) { shadows = enabled; }
+    bool GetShadowsEnabled() { return shadows; }
+
+    // Scratch memory for Scene::Draw, e.g. its InstanceBatches. Draws are copied into the list, so the
+    // renderer resets it once the scene has drawn
+    FrameArena& GetArena() { return arena; }
+
+    // Of the quilt being drawn, for scenes picking a level of detail (see PackedMesh::SelectLOD)
+    void SetTileResolution(std::pair<int, int> tileResolution) { this->tileResolution = tileResolution; }
+    std::pair<int, int> GetTileResolution() { return tileResolution; }
+
+    // Instances in any layout, the material's shader reads the layout's attributes by name.
+    // shadow: also draw every instance's planar shadow with the shadow pass' material
+    void DrawInstances(Mesh mesh, Material material, const InstanceLayout& layout, const void* instances, int count,
+            const ShadowPass* shadow = NULL) {
+        if (count <= 0) return;
+
+        commands.push_back(Command{ mesh, material, &layout, data.size(), count, NULL,
+            shadow != NULL, shadow != NULL ? *shadow : ShadowPass{}, 0, -1 });
+        const unsigned char* bytes = (const unsigned char*)instances;
+        data.insert(data.end(), bytes, bytes + count*layout.stride);
+        instanceCount += count;
+    }
+
+    template <typename T>
+    void DrawInstances(Mesh mesh, Material material, const InstanceLayout& layout, const InstanceBatch<T>& batch,
+            const ShadowPass* shadow = NULL) {
+        DrawInstances(mesh, material, layout, batch.Data(), batch.Count(), shadow);
+    }
+
+    // Full transform and color per instance (MODEL_INSTANCE_LAYOUT)
+    void DrawMeshInstanced(Mesh mesh, Material material, Matrix *instanceTransforms, Vector4 *instanceColors, int instances,
+            const ShadowPass* shadow = NULL) {
+        if (instances <= 0) return;
+
+        staging.resize(instances);
+        for (int i = 0; i < instances; i++) staging[i] = ToModelInstance(instanceTransforms[i], instanceColors[i]);
+        DrawInstances(mesh, material, MODEL_INSTANCE_LAYOUT, staging.data(), instances, shadow);
+    }
+
+    // Drop the instances no view can see (nor their shadow), once per frame before Upload
+    void Cull(const ViewConeCuller& culler) {
+        size_t kept = 0;
+        for (Command& command : commands) {
+            const InstanceLayout& layout = *command.layout;
+            BoundingSphere meshSphere = GetMeshBounds(command.mesh);
+            size_t offset = kept;
+            int visible = 0;
+            command.boundsFirst = bounds.size();
+            for (int i = 0; i < command.count; i++) {
+                const unsigned char* instance = &data[command.offset + i*layout.stride];
+                BoundingSphere sphere = layout.bounds(instance, meshSphere);
+                bool inView = culler.IsVisible(sphere);
+                if (command.hasShadow && shadows) {
+                    // Both passes draw from the same buffer, the BVH has to bound both
+                    BoundingSphere shadowSphere = ProjectBoundingSphere(sphere, command.shadow.plane);
+                    inView = inView || culler.IsVisible(shadowSphere);
+                    sphere = MergeBoundingSpheres(sphere, shadowSphere);
+                }
+                if (!inView) continue;
+
+                // Commands only move towards the front, never past unread instances
+                if (&data[kept] != instance) memmove(&data[kept], instance, layout.stride);
+                bounds.push_back(sphere);
+                kept += layout.stride;
+                visible++;
+            }
+            culled += command.count - visible;
+            instanceCount -= command.count - visible;
+            command.offset = offset;
+            command.count = visible;
+        }
+        data.resize(kept);
+    }
+
+    // Sort the instances of commands with at least minInstances into a BVH, so Replay draws only
+    // what each view sees. After Cull, and only when every view is replayed on its own
+    void BuildViewBVH(int minInstances) {
+        for (Command& command : commands) {
+            if (command.count < minInstances || (int)bounds.size() < command.boundsFirst + command.count) continue;
+
+            if (bvhCount == (int)bvhs.size()) bvhs.emplace_back();
+            command.bvh = bvhCount++;
+            bvhs[command.bvh].Build(&bounds[command.boundsFirst], command.count, order);
+
+            int stride = command.layout->stride;
+            reordered.resize(command.count*stride);
+            for (int i = 0; i < command.count; i++)
+                memcpy(&reordered[i*stride], &data[command.offset + order[i]*stride], stride);
+            std::copy(reordered.begin(), reordered.end(), data.begin() + command.offset);
+        }
+    }
+
+    // Upload every command's instances once per frame, before the first Replay
+    void Upload() {
+        for (size_t i = 0; i < commands.size(); i++) {
+            Command& command = commands[i];
+
+            // Repeated mesh+material pairs get their own stream so earlier draws aren't overwritten
+            int slot = 0;
+            for (size_t j = 0; j < i; j++) {
+                if (commands[j].mesh.vboId[0] == command.mesh.vboId[0]
+                        && commands[j].material.shader.id == command.material.shader.id)
+                    slot++;
+            }
+
+            if (command.count == 0) continue;
+            command.stream = GetInstanceStream(command.mesh, command.material, *command.layout, slot);
+            UploadInstanceStream(command.stream, &data[command.offset], command.count);
+        }
+    }
+
+    void Replay() {
+        Frustum frustum;
+        if (bvhCount > 0) frustum = Frustum::FromMatrix(MatrixMultiply(rlGetMatrixModelview(), rlGetMatrixProjection()));
+
+        for (const Command& command : commands) {
+            bool drawShadow = command.hasShadow && shadows;
+            if (command.bvh < 0) {
+                DrawInstanceStream(command.mesh, command.material, command.stream, command.count);
+                if (drawShadow) DrawInstanceStream(command.mesh, command.shadow.material, command.stream, command.count);
+                continue;
+            }
+            ranges.clear();
+            bvhs[command.bvh].Query(frustum, ranges);
+            for (const std::pair<int, int>& range : ranges)
+                DrawInstanceStream(command.mesh, command.material, command.stream, range.second, range.first);
+            if (drawShadow) {
+                for (const std::pair<int, int>& range : ranges)
+                    DrawInstanceStream(command.mesh, command.shadow.material, command.stream, range.second, range.first);
+            }
+        }
+    }
+
+    // FNV-1a over everything the frame submits, equal hashes mean the quilt would render the same
+    unsigned long long GetHash() {
+        unsigned long long hash = 14695981039346656037ULL;
+        auto add = [&](const void* bytes, size_t size) {
+            for (size_t i = 0; i < size; i++) {
+                hash ^= ((const unsigned char*)bytes)[i];
+                hash *= 1099511628211ULL;
+            }
+        };
+        for (const Command& command : commands) {
+            add(&command.mesh.vboId[0], sizeof(unsigned int));
+            add(&command.material.shader.id, sizeof(unsigned int));
+            add(&command.material.maps[MATERIAL_MAP_DIFFUSE].texture.id, sizeof(unsigned int));
+            add(&command.layout, sizeof(command.layout));
+            add(&command.count, sizeof(int));
+            if (command.hasShadow && shadows) add(&command.shadow.material.shader.id, sizeof(unsigned int));
+        }
+        add(data.data(), data.size());
+        return hash;
+    }
+
+    int GetCommandCount() { return commands.size(); }
+    int GetInstanceCount() { return instanceCount; }
+    int GetCulledCount() { return culled; }
+};
+
+#endif
@@ -0,0 +1,151 @@
+#ifndef FRAMEARENA_H
+#define FRAMEARENA_H
+
+#include <vector>
+#include <cstdlib>
+#include <cstring>
+#include <cstddef>
+#include <algorithm>
+#include <type_traits>
+
+// Scratch memory for building one frame, e.g. the instances a Scene::Draw builds before DrawList copies
+// them. Allocating bumps an offset into the current block and Reset frees everything at once. A frame
+// that doesn't fit gets more blocks, and Reset merges them into one block as large as all of them, so
+// once a scene's largest frame has been built the arena doesn't allocate again.
+class FrameArena {
+private:
+    struct Block {
+        unsigned char *data;
+        size_t size;
+    };
+    std::vector<Block> blocks;  // Allocating from the last one
+    size_t blockSize;           // Of the first block
+    size_t offset = 0;          // Into the last block
+    size_t used = 0;            // This frame, alignment padding included
+
+    size_t lastUsed = 0;        // By the frame before the last Reset
+    size_t highWater = 0;
+    int blocksAllocated = 0;    // Since the arena was created
+
+    static size_t AlignUp(size_t offset, size_t align) { return (offset + align - 1) & ~(align - 1); }
+
+    void AddBlock(size_t size) {
+        // malloc aligns for any fundamental type, enough for every instance struct
+        blocks.push_back(Block{ (unsigned char *)std::malloc(size), size });
+        offset = 0;
+        blocksAllocated++;
+    }
+    void FreeBlocks() {
+        for (Block& block : blocks) std::free(block.data);
+        blocks.clear();
+    }
+public:
+    FrameArena(size_t blockSize = 256*1024) : blockSize(blockSize) { }
+    ~FrameArena() { FreeBlocks(); }
+    FrameArena(const FrameArena&) = delete;
+    FrameArena& operator=(const FrameArena&) = delete;
+
+    // Valid until the next Reset. align is a power of two, at most alignof(std::max_align_t)
+    void* Allocate(size_t size, size_t align = alignof(std::max_align_t)) {
+        size_t start = blocks.empty() ? 0 : AlignUp(offset, align);
+        if (blocks.empty() || start + size > blocks.back().size) {
+            AddBlock(std::max(size, blocks.empty() ? blockSize : blocks.back().size*2));
+            start = 0;
+        }
+        used += start - offset + size;
+        offset = start + size;
+        return blocks.back().data + start;
+    }
+    template <typename T>
+    T* Allocate(size_t count) { return (T *)Allocate(count*sizeof(T), alignof(T)); }
+
+    // Grow the last allocation in place, if there's room in its block. Returns whether it grew
+    bool Extend(void *allocation, size_t size, size_t newSize) {
+        if (blocks.empty()) return false;
+        const Block& block = blocks.back();
+        if ((unsigned char *)allocation + size != block.data + offset || offset - size + newSize > block.size) return false;
+        used += newSize - size;
+        offset += newSize - size;
+        return true;
+    }
+
+    // At the end of the frame, frees everything allocated since the last Reset
+    void Reset() {
+        highWater = std::max(highWater, used);
+        lastUsed = used;
+        if (blocks.size() > 1) {
+            size_t total = 0;
+            for (const Block& block : blocks) total += block.size;
+            FreeBlocks();
+            AddBlock(total);
+        }
+        offset = 0;
+        used = 0;
+    }
+
+    size_t GetLastUsed() const { return lastUsed; }
+    // Most bytes any frame used
+    size_t GetHighWater() const { return std::max(highWater, used); }
+    size_t GetCapacity() const {
+        size_t capacity = 0;
+        for (const Block& block : blocks) capacity += block.size;
+        return capacity;
+    }
+    // Steady state frames leave this unchanged
+    int GetBlocksAllocated() const { return blocksAllocated; }
+};
+
+// A growable array of instances (or anything trivially copyable) in a FrameArena, valid until the
+// arena's Reset. Grows in place while it's the arena's last allocation, otherwise moves to a larger one
+template <typename T>
+class InstanceBatch {
+    static_assert(std::is_trivially_copyable<T>::value, "Instances are moved with memcpy");
+private:
+    FrameArena *arena;
+    T *items = NULL;
+    int count = 0;
+    int capacity = 0;
+    int highWater = 0;
+
+    void Reserve(int needed) {
+        if (needed <= capacity) return;
+        int grown = std::max(needed, std::max(capacity*2, 64));
+        if (items != NULL && arena->Extend(items, capacity*sizeof(T), grown*sizeof(T))) {
+            capacity = grown;
+            return;
+        }
+        T *moved = arena->Allocate<T>(grown);
+        if (count > 0) memcpy(moved, items, count*sizeof(T));
+        items = moved;
+        capacity = grown;
+    }
+public:
+    // capacity: expected instances, so a batch of known size is allocated once
+    InstanceBatch(FrameArena& arena, int capacity = 0) : arena(&arena) { Reserve(capacity); }
+
+    void Push(const T& item) {
+        Reserve(count + 1);
+        items[count++] = item;
+        highWater = std::max(highWater, count);
+    }
+    // Room for n more instances at the end, to be written in place
+    T* Append(int n) {
+        Reserve(count + n);
+        T *first = items + count;
+        count += n;
+        highWater = std::max(highWater, count);
+        return first;
+    }
+    void Clear() { count = 0; }
+
+    T& operator[](int i) { return items[i]; }
+    const T& operator[](int i) const { return items[i]; }
+    T* Data() { return items; }
+    const T* Data() const { return items; }
+    int Count() const { return count; }
+    // Most instances the batch held, e.g. between Clears
+    int GetHighWater() const { return highWater; }
+    FrameArena& GetArena() const { return *arena; }
+};
+
+#endif
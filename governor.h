@@ -0,0 +1,130 @@
+#ifndef GOVERNOR_H
+#define GOVERNOR_H
+
+#include <cmath>
+#include <string>
+#include <vector>
+#include <fstream>
+#include <iostream>
+
+struct QualityLevel {
+    std::pair<int, int> tiles;
+    std::pair<int, int> tileRes;
+    bool shadows;
+
+    std::string ToString() const {
+        return std::to_string(tileRes.first) + "x" + std::to_string(tileRes.second)
+            + " @ " + std::to_string(tiles.first) + "x" + std::to_string(tiles.second)
+            + (shadows ? "" : ", no shadows");
+    }
+};
+
+// Closed loop quality control: steps the quilt down a ladder of tile resolutions, shadows and view counts
+// when frames are slow (or the SoC is hot) and back up once there is headroom again.
+// Level 0 is the scene's own configuration, higher levels are cheaper.
+class QualityGovernor {
+private:
+    std::vector<QualityLevel> ladder;
+    int level = 0;
+
+    float targetFrameTime;
+    std::string thermalPath;
+    float thermalLimit;
+
+    // Frame times are averaged over windows, decisions are only made once per window
+    const float WINDOW_LENGTH = 1.0f;
+    float windowTime = 0.0f;
+    int windowFrames = 0;
+
+    // Hysteresis: step down after one slow window, step up only after several fast ones
+    const float STEP_DOWN_RATIO = 1.1f;     // Average frame time above target * ratio
+    const float STEP_UP_RATIO = 0.7f;       // Average frame time below target * ratio
+    const int STEP_UP_WINDOWS = 5;
+    const float THERMAL_MARGIN = 5.0f;      // Degrees below the limit before stepping back up
+    int fastWindows = 0;
+
+    // Frames right after a change pay for the quilt reallocation, don't count them
+    const int SETTLE_FRAMES = 2;
+    int settleFrames = 0;
+
+    // Millidegrees celsius, as reported by /sys/class/thermal/thermal_zone*/temp
+    float ReadTemperature() {
+        if (thermalPath.empty()) return NAN;
+        std::ifstream thermalFile(thermalPath);
+        float milliCelsius;
+        if (!(thermalFile >> milliCelsius)) return NAN;
+        return milliCelsius / 1000.0f;
+    }
+
+    void SetLevel(int newLevel, float averageFrameTime, float temperature, const char* reason) {
+        std::cout << "INFO: Governor " << reason << ": level " << level << " (" << ladder[level].ToString() << ") -> "
+            << newLevel << " (" << ladder[newLevel].ToString() << "), avg " << averageFrameTime * 1000.0f << " ms";
+        if (!std::isnan(temperature)) std::cout << ", " << temperature << " C";
+        std::cout << std::endl;
+
+        level = newLevel;
+        fastWindows = 0;
+        settleFrames = SETTLE_FRAMES;
+    }
+public:
+    QualityGovernor(std::pair<int, int> tiles, std::pair<int, int> tileRes, float targetFPS,
+            std::string thermalPath = "", float thermalLimit = 75.0f)
+        : targetFrameTime(1.0f/targetFPS), thermalPath(thermalPath), thermalLimit(thermalLimit) {
+        ladder.push_back(QualityLevel{ tiles, tileRes, true });
+
+        // Same tile resolutions the scenes choose from, below the scene's own
+        const std::pair<int, int> resolutions[] = { {420, 560}, {315, 420}, {252, 336}, {168, 224}, {126, 168} };
+        for (auto res : resolutions) {
+            if (res.first < tileRes.first)
+                ladder.push_back(QualityLevel{ tiles, res, true });
+        }
+
+        // Then no shadow passes, and fewer views, at the lowest resolution
+        ladder.push_back(QualityLevel{ tiles, ladder.back().tileRes, false });
+        const std::pair<int, int> viewCounts[] = { {7, 5}, {6, 4}, {5, 3} };
+        for (auto count : viewCounts) {
+            if (count.first * count.second < ladder.back().tiles.first * ladder.back().tiles.second)
+                ladder.push_back(QualityLevel{ count, ladder.back().tileRes, false });
+        }
+    }
+
+    QualityLevel GetLevel() { return ladder[level]; }
+
+    // Feed one frame, returns true when the quality level changed
+    bool Update(float frameTime) {
+        if (settleFrames > 0) {
+            settleFrames--;
+            return false;
+        }
+
+        windowTime += frameTime;
+        windowFrames++;
+        if (windowTime < WINDOW_LENGTH) return false;
+
+        float averageFrameTime = windowTime / windowFrames;
+        float temperature = ReadTemperature();
+        bool hot = !std::isnan(temperature) && temperature > thermalLimit;
+        bool cool = std::isnan(temperature) || temperature < thermalLimit - THERMAL_MARGIN;
+        windowTime = 0.0f;
+        windowFrames = 0;
+
+        int lastLevel = ladder.size() - 1;
+        if ((hot || averageFrameTime > targetFrameTime * STEP_DOWN_RATIO) && level < lastLevel) {
+            SetLevel(level + 1, averageFrameTime, temperature, hot ? "thermal" : "slow");
+            return true;
+        }
+
+        if (cool && averageFrameTime < targetFrameTime * STEP_UP_RATIO && level > 0)
+            fastWindows++;
+        else
+            fastWindows = 0;
+
+        if (fastWindows >= STEP_UP_WINDOWS) {
+            SetLevel(level - 1, averageFrameTime, temperature, "headroom");
+            return true;
+        }
+        return false;
+    }
+};
+
+#endif
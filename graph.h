@@ -11,6 +11,8 @@
 
 #include "scene.h"
 #include "raylib_extensions.h"
+#include "text.h"
+#include "resources.h"
 
 class GraphScene : public Scene
 {
@@ -20,70 +22,38 @@ private:
 
     Shader textShader;
     Material textMaterial;
+    TextureHandle fontAtlas;    // Placeholder until loaded, read into textMaterial every Draw
 
     Mesh quadMesh;
 
-    float PackColor(Vector4 color) {
-       return floor(color.x * 128.0f + 0.5f)
-        + floor(color.z * 128.0f + 0.5f) * 129.0f
-        + floor(color.y * 128.0f + 0.5f) * 129.0f * 129.0f;
-    }
-
     // LINE
     float LINE_WIDTH = 0.15f;
     float GRAPH_SEGMENT = 0.125f;
     Color LINE_COLOR = Color{255,255,255,255};//Color{38,182,128,255};
     //const Color LINE_COLOR = Color{38,182,128,255};
-    void DrawLine(Vector3 start, Vector3 end, float width, Color color,
-            Matrix* transforms, Vector4* colors, int& instanceIdx);
     void DrawCubeLines(float size,
-            Matrix* transforms, Vector4* colors, int& instanceIdx);
+            InstanceBatch<LineInstance>& lines);
     void DrawCircleLines(float radius, int segments,
-            Matrix* transforms, Vector4* colors, int& instanceIdx);
+            InstanceBatch<LineInstance>& lines);
 
     // TEXT
-    void DrawChar(Matrix m, Color col, char c,
-            Matrix* transforms, Vector4* colors, int& instanceIdx);
-    void DrawText(std::string text, Color col, float scale,
-            Matrix* transforms, Vector4* colors, int& instanceIdx);
+    const std::string GREETING = "Hello world";
+    TextLayoutCache textLayouts;
 public:
     GraphScene() {
         std::cout << "[INITIALIZING SCENE]: Graph" << std::endl;
 
-        Vector3 shadowColor = Vector3{0.0f, 0.0f, 0.0f};
-        Vector3 lightPos = Vector3{0.0f, -3.0f, 22.0f};
-        float planeZ = -2.0f;
-        
         // LINE SHADER ----------
-        lineShader = LoadShaderSingleFile("./Shaders/line_instanced.shader");
-        lineShader.locs[SHADER_LOC_MATRIX_MODEL] = GetShaderLocationAttrib(lineShader, "matModel");
-        lineShader.locs[SHADER_LOC_COLOR_DIFFUSE] = GetShaderLocationAttrib(lineShader, "direction");
-        lineShader.locs[SHADER_LOC_MATRIX_VIEW] = GetShaderLocation(lineShader, "matView");
-        lineShader.locs[SHADER_LOC_MATRIX_PROJECTION] = GetShaderLocation(lineShader, "matProjection");
-        float glow = 0.7f;
-        float glowFalloff = 15.0f;
-        SetShaderValue(lineShader, GetShaderLocation(lineShader, "glow"), &glow, SHADER_UNIFORM_FLOAT);
-        SetShaderValue(lineShader, GetShaderLocation(lineShader, "glowFalloff"), &glowFalloff, SHADER_UNIFORM_FLOAT);
-
+        lineShader = resources.AcquireShader("./Shaders/line_instanced.shader");
         lineMaterial = LoadMaterialDefault(); // Line material
         lineMaterial.shader = lineShader;
 
-        rlDisableBackfaceCulling();
-
         // TEXT SHADER ----------
-        textShader = LoadShaderSingleFile("./Shaders/text.shader");
-        textShader.locs[SHADER_LOC_MATRIX_MODEL] = GetShaderLocationAttrib(textShader, "matModel");
-        textShader.locs[SHADER_LOC_COLOR_DIFFUSE] = GetShaderLocationAttrib(textShader, "colDiffuse");
-        textShader.locs[SHADER_LOC_MATRIX_VIEW] = GetShaderLocation(textShader, "matView");
-        textShader.locs[SHADER_LOC_MATRIX_PROJECTION] = GetShaderLocation(textShader, "matProjection");
-
-        Vector2 atlasSize = Vector2{15, 8};
-        SetShaderValue(textShader, GetShaderLocation(textShader, "atlasSize"), &atlasSize, SHADER_UNIFORM_VEC2);
-
-        textShader.locs[SHADER_LOC_MAP_ALBEDO] = GetShaderLocation(textShader, "texture1");
+        textShader = resources.AcquireShader("./Shaders/text.shader");
 
         MaterialMap fontAtlasMap = { 0 };
-        fontAtlasMap.texture = LoadTexture("./Textures/FontAtlas.png");
+        fontAtlas = resources.AcquireTexture("./Textures/FontAtlas.png");
+        fontAtlasMap.texture = fontAtlas.Get();
         fontAtlasMap.color = WHITE;
 
         textMaterial = LoadMaterialDefault(); // Text material
@@ -91,25 +61,35 @@ public:
         textMaterial.maps[0] = fontAtlasMap;
 
         // MESHES ----------
-        quadMesh = GenMeshPlaneY(1.0f, 1.0f, 1, 1);
+        quadMesh = resources.AcquireMesh("planeY 1 1", [] { return GenMeshPlaneY(1.0f, 1.0f, 1, 1); });
     }
     ~GraphScene() {
-        UnloadShader(lineShader);
-        UnloadShader(textShader);
+        resources.ReleaseShader(lineShader);
+        resources.ReleaseShader(textShader);
+        resources.ReleaseTexture(fontAtlas);
+        resources.ReleaseMesh(quadMesh);
+        UnloadMaterialMaps(lineMaterial);
+        UnloadMaterialMaps(textMaterial);
     }
-    void Update() {
-        float deltaTime = GetFrameTime();
-    }
-    void Draw() {
-        float gameTime = GetTime() * 2.0f;
+    void Activate() {
+        float glow = 0.7f;
+        float glowFalloff = 15.0f;
+        SetShaderValue(lineShader, GetShaderLocation(lineShader, "glow"), &glow, SHADER_UNIFORM_FLOAT);
+        SetShaderValue(lineShader, GetShaderLocation(lineShader, "glowFalloff"), &glowFalloff, SHADER_UNIFORM_FLOAT);
+
+        Vector2 atlasSize = Vector2{15, 8};
+        SetShaderValue(textShader, GetShaderLocation(textShader, "atlasSize"), &atlasSize, SHADER_UNIFORM_VEC2);
 
-        Matrix lineTransforms[1500];
-        Vector4 lineColors[1500];
-        int lineInstanceIdx = 0;
+        rlDisableBackfaceCulling();
+    }
+    void Update(float deltaTime) { }
+    bool SupportsThreadedUpdate() { return true; }
+    void Draw(DrawList& list, double time, float alpha) {
+        textMaterial.maps[0].texture = fontAtlas.Get();
+        float gameTime = time * 2.0f;
 
-        Matrix textTransforms[1500];
-        Vector4 textColors[1500];
-        int textInstanceIdx = 0;
+        InstanceBatch<LineInstance> lines(list.GetArena());
+        InstanceBatch<ModelInstance> glyphs(list.GetArena());
 
         rlPushMatrix();
             float space = 0.4f;
@@ -118,42 +98,43 @@ public:
                 rlTranslatef(0, 0, space);
                 //rlRotatef(((i+5)/10.0f) * 180.0f, 0, 1, 0);
                 this->DrawCircleLines(0.6f + sin(gameTime + i * space) * 0.3f, 18,
-                        lineTransforms, lineColors, lineInstanceIdx);
+                        lines);
             }
         rlPopMatrix();
 
         rlPushMatrix();
             rlTranslatef(0, 1.25f, 0);
+            InstanceBatch<Vector3> endpoints(list.GetArena());
             for (float x = -1.8f; x <= 1.8f; x += GRAPH_SEGMENT) {
                 float a = x*3.0f + gameTime;
                 float b = (x + GRAPH_SEGMENT)*3.0f + gameTime;
-                this->DrawLine(Vector3{x, sin(a), cos(a)},
-                        Vector3{x + GRAPH_SEGMENT, sin(b), cos(b)}, LINE_WIDTH, LINE_COLOR,
-                        lineTransforms, lineColors, lineInstanceIdx);
+                endpoints.Push(Vector3{x, sin(a), cos(a)});
+                endpoints.Push(Vector3{x + GRAPH_SEGMENT, sin(b), cos(b)});
             }
+            AppendLineInstances(rlGetMatrixTransform(), endpoints.Data(), endpoints.Count(), LINE_WIDTH, LINE_COLOR,
+                    lines);
         rlPopMatrix();
         rlPushMatrix();
             rlTranslatef(0.0f, -1.25f, 0);
             rlRotatef(gameTime * 5.0f, 1, 1, 1);
                 this->DrawCubeLines(0.6f,
-                        lineTransforms, lineColors, lineInstanceIdx);
+                        lines);
         rlPopMatrix();
         rlPushMatrix();
             rlScalef(1.8f, 2.2f, 1.0f);
             this->DrawCubeLines(1.0f,
-                    lineTransforms, lineColors, lineInstanceIdx);
+                    lines);
         rlPopMatrix();
 
         rlPushMatrix();
             rlTranslatef(-1.35f, 1.0f, 0);
-            this->DrawText("Hello world", LINE_COLOR, 0.7f,
-                    textTransforms, textColors, textInstanceIdx);
+            DrawGlyphRun(textLayouts.Get(GREETING, FONT_ATLAS, 0.7f, 0.5f), rlGetMatrixTransform(), LINE_COLOR, glyphs);
         rlPopMatrix();
 
         // Lines
         //BeginBlendMode(BLEND_ADDITIVE);
-        DrawMeshInstancedC(quadMesh, lineMaterial, lineTransforms, lineColors, lineInstanceIdx);
-        DrawMeshInstancedC(quadMesh, textMaterial, textTransforms, textColors, textInstanceIdx);
+        list.DrawInstances(quadMesh, lineMaterial, LINE_INSTANCE_LAYOUT, lines);
+        list.DrawInstances(quadMesh, textMaterial, MODEL_INSTANCE_LAYOUT, glyphs);
     }
 
     Color GetClearColor() {
@@ -169,90 +150,24 @@ public:
     std::pair<float, float> GetAngleDistance() { return std::pair<float, float>(30.0f, 20.0f); }
 };
 
-/* TEXT DRAWING FUNCTIONS */
-
-void GraphScene::DrawChar(Matrix m, Color col, char c,
-        Matrix* transforms, Vector4* colors, int& instanceIdx) {
-    colors[instanceIdx] = ColorNormalize(Color{col.r,col.g,col.b,c-32});
-    transforms[instanceIdx++] = MatrixMultiply(MatrixScale(0.5f, 1.0f, 1.0f), m);
-};
-void GraphScene::DrawText(std::string text, Color col, float scale,
-        Matrix* transforms, Vector4* colors, int& instanceIdx) {
-    rlPushMatrix();
-        rlScalef(scale, scale, scale);
-        for (char c : text) {
-            if (c != 0) this->DrawChar(rlGetMatrixTransform(), col, c,
-                    transforms, colors, instanceIdx);
-            rlTranslatef(0.4f, 0, 0);
-        }
-    rlPopMatrix();
-};
-
 /* LINE DRAWING FUNCTIONS */
 
-void GraphScene::DrawLine(Vector3 start, Vector3 end, float width, Color color,
-        Matrix* transforms, Vector4* colors, int& instanceIdx) {
-    Vector3 midpoint = Vector3Lerp(start, end, 0.5f);
-    Vector3 direction = Vector3Normalize(Vector3Subtract(end, start));
-    float distance = Vector3Distance(end, start);
-
-    // Matrix Transformation
-    Matrix matTranslation = MatrixTranslate(midpoint.x, midpoint.y, midpoint.z);
-    Matrix matScale = MatrixScale(/*width*/0.0f, distance, 1.0f);
-
-    Quaternion fromToRotation = QuaternionFromVector3ToVector3(Vector3{0,1.0f,0}, direction);
-    Matrix matRotation = QuaternionToMatrix(fromToRotation);
-    Matrix matTransform = MatrixMultiply(MatrixMultiply(matScale, matRotation), matTranslation);
-
-    // Line screen direction
-    Matrix matModelView = MatrixMultiply(rlGetMatrixTransform(), rlGetMatrixModelview());
-    Matrix mvp = MatrixMultiply(matModelView, rlGetMatrixProjection());
-
-    Vector4 projStart = Vector4Transform(Vector4{start.x,start.y,start.z,1.0f}, mvp);
-    Vector2 screenStart = Vector2Scale(Vector2{projStart.x, projStart.y}, 1.0f/projStart.w);
-    screenStart.x *= 1536.0f/2048.0f;
-    Vector4 projEnd = Vector4Transform(Vector4{end.x,end.y,end.z,1.0f}, mvp);
-    Vector2 screenEnd = Vector2Scale(Vector2{projEnd.x, projEnd.y}, 1.0f/projEnd.w);
-    screenEnd.x *= 1536.0f/2048.0f;
-    Vector2 screenDir = Vector2Normalize(Vector2Subtract(screenEnd, screenStart));
-
-    // Instance values
-    colors[instanceIdx] = Vector4{screenDir.x,screenDir.y,width,this->PackColor(ColorNormalize(color))};
-    transforms[instanceIdx++] = MatrixMultiply(matTransform, rlGetMatrixTransform());
-}
-void GraphScene::DrawCubeLines(float s, Matrix* transforms, Vector4* colors, int& instanceIdx) {
-    this->DrawLine(Vector3{s, s, s}, Vector3{-s, s, s}, LINE_WIDTH, LINE_COLOR,
-            transforms, colors, instanceIdx); // -
-    this->DrawLine(Vector3{s, -s, s}, Vector3{-s, -s, s}, LINE_WIDTH, LINE_COLOR,
-            transforms, colors, instanceIdx);
-    this->DrawLine(Vector3{s, s, -s}, Vector3{-s, s, -s}, LINE_WIDTH, LINE_COLOR,
-            transforms, colors, instanceIdx);
-    this->DrawLine(Vector3{s, -s, -s}, Vector3{-s, -s, -s}, LINE_WIDTH, LINE_COLOR,
-            transforms, colors, instanceIdx);
-    this->DrawLine(Vector3{s, s, s}, Vector3{s, s, -s}, LINE_WIDTH, LINE_COLOR,
-            transforms, colors, instanceIdx); // -
-    this->DrawLine(Vector3{s, -s, s}, Vector3{s, -s, -s}, LINE_WIDTH, LINE_COLOR,
-            transforms, colors, instanceIdx);
-    this->DrawLine(Vector3{-s, s, s}, Vector3{-s, s, -s}, LINE_WIDTH, LINE_COLOR,
-            transforms, colors, instanceIdx);
-    this->DrawLine(Vector3{-s, -s, s}, Vector3{-s, -s, -s}, LINE_WIDTH, LINE_COLOR,
-            transforms, colors, instanceIdx);
-    this->DrawLine(Vector3{s, s, s}, Vector3{s, -s, s}, LINE_WIDTH, LINE_COLOR,
-            transforms, colors, instanceIdx); // -
-    this->DrawLine(Vector3{s, s, -s}, Vector3{s, -s, -s}, LINE_WIDTH, LINE_COLOR,
-            transforms, colors, instanceIdx);
-    this->DrawLine(Vector3{-s, s, s}, Vector3{-s, -s, s}, LINE_WIDTH, LINE_COLOR,
-            transforms, colors, instanceIdx);
-    this->DrawLine(Vector3{-s, s, -s}, Vector3{-s, -s, -s}, LINE_WIDTH, LINE_COLOR,
-            transforms, colors, instanceIdx);
+void GraphScene::DrawCubeLines(float s, InstanceBatch<LineInstance>& lines) {
+    Vector3 edges[24];
+    for (int i = 0; i < 24; i++) edges[i] = Vector3Scale(CUBE_EDGE_LINES[i], s);
+    AppendLineInstances(rlGetMatrixTransform(), edges, 24, LINE_WIDTH, LINE_COLOR,
+            lines);
 }
-void GraphScene::DrawCircleLines(float radius, int segments, Matrix* transforms, Vector4* colors, int& instanceIdx) {
+void GraphScene::DrawCircleLines(float radius, int segments, InstanceBatch<LineInstance>& lines) {
+    InstanceBatch<Vector3> endpoints(lines.GetArena(), segments*2);
     for (int i = 0; i < segments; i++) {
         float angle = ((float)i/(float)segments) * PI * 2.0f;
         float next_angle = ((float)(i+1)/(float)segments) * PI * 2.0f;
         auto p = Vector3{cos(angle), sin(angle), 0};
         auto n = Vector3{cos(next_angle), sin(next_angle), 0};
-        this->DrawLine(Vector3Scale(p, radius), Vector3Scale(n, radius), LINE_WIDTH, LINE_COLOR,
-                transforms, colors, instanceIdx);
+        endpoints.Push(Vector3Scale(p, radius));
+        endpoints.Push(Vector3Scale(n, radius));
     }
+    AppendLineInstances(rlGetMatrixTransform(), endpoints.Data(), endpoints.Count(), LINE_WIDTH, LINE_COLOR,
+            lines);
 }
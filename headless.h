@@ -0,0 +1,93 @@
+#ifndef HEADLESS_H
+#define HEADLESS_H
+
+#include "raylib.h"
+#include "rlgl.h"
+
+#include <EGL/egl.h>
+#include <EGL/eglext.h>
+#include <GLES3/gl3.h>
+
+#include <string>
+#include <iostream>
+
+#ifndef EGL_PLATFORM_SURFACELESS_MESA
+#define EGL_PLATFORM_SURFACELESS_MESA 0x31DD
+#endif
+
+// Offscreen GLES3 context for running without a display (build machines, CI), used instead of InitWindow.
+// Prefers Mesa's surfaceless platform (works with llvmpipe, e.g. LIBGL_ALWAYS_SOFTWARE=1) and falls back
+// to the default display. Only rlgl is initialized, so everything must render into render textures.
+class HeadlessContext {
+private:
+    EGLDisplay display = EGL_NO_DISPLAY;
+    EGLContext context = EGL_NO_CONTEXT;
+    EGLSurface surface = EGL_NO_SURFACE;
+
+    static EGLDisplay GetDisplay() {
+        const char* extensions = eglQueryString(EGL_NO_DISPLAY, EGL_EXTENSIONS);
+        if (extensions != NULL && std::string(extensions).find("EGL_MESA_platform_surfaceless") != std::string::npos) {
+            PFNEGLGETPLATFORMDISPLAYEXTPROC getPlatformDisplay =
+                (PFNEGLGETPLATFORMDISPLAYEXTPROC)eglGetProcAddress("eglGetPlatformDisplayEXT");
+            if (getPlatformDisplay != NULL)
+                return getPlatformDisplay(EGL_PLATFORM_SURFACELESS_MESA, EGL_DEFAULT_DISPLAY, NULL);
+        }
+        return eglGetDisplay(EGL_DEFAULT_DISPLAY);
+    }
+public:
+    // Returns false (after logging why) if no context could be created
+    bool Init(int width, int height) {
+        display = GetDisplay();
+        EGLint major, minor;
+        if (display == EGL_NO_DISPLAY || !eglInitialize(display, &major, &minor)) {
+            std::cout << "WARNING: Headless: no EGL display\n";
+            return false;
+        }
+        eglBindAPI(EGL_OPENGL_ES_API);
+
+        const EGLint configAttributes[] = {
+            EGL_SURFACE_TYPE, EGL_PBUFFER_BIT,
+            EGL_RENDERABLE_TYPE, EGL_OPENGL_ES3_BIT,
+            EGL_RED_SIZE, 8, EGL_GREEN_SIZE, 8, EGL_BLUE_SIZE, 8, EGL_ALPHA_SIZE, 8,
+            EGL_DEPTH_SIZE, 24,
+            EGL_NONE
+        };
+        EGLConfig config;
+        EGLint configCount = 0;
+        if (!eglChooseConfig(display, configAttributes, &config, 1, &configCount) || configCount == 0) {
+            std::cout << "WARNING: Headless: no GLES3 pbuffer config\n";
+            return false;
+        }
+
+        const EGLint contextAttributes[] = { EGL_CONTEXT_CLIENT_VERSION, 3, EGL_NONE };
+        context = eglCreateContext(display, config, EGL_NO_CONTEXT, contextAttributes);
+        const EGLint surfaceAttributes[] = { EGL_WIDTH, width, EGL_HEIGHT, height, EGL_NONE };
+        surface = eglCreatePbufferSurface(display, config, surfaceAttributes);
+        if (context == EGL_NO_CONTEXT || surface == EGL_NO_SURFACE || !eglMakeCurrent(display, surface, surface, context)) {
+            std::cout << "WARNING: Headless: couldn't create a GLES3 context\n";
+            return false;
+        }
+
+        std::cout << "INFO: Headless: EGL " << major << "." << minor << ", " << glGetString(GL_RENDERER) << "\n";
+        rlLoadExtensions((void*)eglGetProcAddress);
+        rlglInit(width, height);
+        return true;
+    }
+    ~HeadlessContext() {
+        if (display == EGL_NO_DISPLAY) return;
+        if (context != EGL_NO_CONTEXT) rlglClose();
+        eglMakeCurrent(display, EGL_NO_SURFACE, EGL_NO_SURFACE, EGL_NO_CONTEXT);
+        if (surface != EGL_NO_SURFACE) eglDestroySurface(display, surface);
+        if (context != EGL_NO_CONTEXT) eglDestroyContext(display, context);
+        eglTerminate(display);
+    }
+};
+
+// Read back a render texture as an image the right way up
+Image LoadImageFromRenderTexture(RenderTexture2D target) {
+    Image image = LoadImageFromTexture(target.texture);
+    ImageFlipVertical(&image);
+    return image;
+}
+
+#endif
@@ -0,0 +1,156 @@
+#ifndef INTERLEAVER_H
+#define INTERLEAVER_H
+
+#include "raylib.h"
+#include "rlgl.h"
+
+#include <string>
+#include <iostream>
+
+#include "config.h"
+#include "raylib_extensions.h"
+#include "quilt.h"
+
+enum class InterleaveMode : unsigned char {
+    Analytic,   // Work out the view of every subpixel in the shader each frame
+    Lut,        // Look the views up in a texture baked whenever the calibration or tiles change
+    LutCompare  // Lut, but highlight subpixels that disagree with the analytic result
+};
+
+// Turns the quilt into the lenticular image (Shaders/quilt.shader).
+// The view of each subpixel only depends on the calibration and tile count, so in the Lut modes
+// it is baked once into an RGBA8 texture (one view index per channel) instead of recomputing
+// the pitch/tilt/fract chain for every pixel of every frame.
+// Owns GL objects, delete before CloseWindow.
+class Interleaver {
+private:
+    InterleaveMode mode;
+    bool highp;
+    int width;
+    int height;
+
+    Shader shader = { 0 };
+    int quiltTexLoc;
+    int lutLoc;
+
+    // Bakes the LUT, same shader with QUILT_BAKE_LUT
+    Shader bakeShader = { 0 };
+    RenderTexture2D lut = { 0 };
+
+    LKGConfig config;
+    std::pair<int, int> tiles = { 1, 1 };
+
+    static std::string GetPrecisionDefines(bool highp) {
+        return highp ? "#define QUILT_HIGHP\n" : "";
+    }
+
+    static void SetUniforms(Shader shader, const LKGConfig& config, std::pair<int, int> tiles, int width, int height) {
+        SetShaderValue(shader, GetShaderLocation(shader, "pitch"), &config.pitch, SHADER_UNIFORM_FLOAT);
+        SetShaderValue(shader, GetShaderLocation(shader, "slope"), &config.slope, SHADER_UNIFORM_FLOAT);
+        SetShaderValue(shader, GetShaderLocation(shader, "center"), &config.center, SHADER_UNIFORM_FLOAT);
+        SetShaderValue(shader, GetShaderLocation(shader, "dpi"), &config.dpi, SHADER_UNIFORM_FLOAT);
+
+        float tile[2] = { (float)tiles.first, (float)tiles.second };
+        SetShaderValue(shader, GetShaderLocation(shader, "tile"), tile, SHADER_UNIFORM_VEC2);
+        float resolution[2] = { (float)width, (float)height };
+        SetShaderValue(shader, GetShaderLocation(shader, "resolution"), resolution, SHADER_UNIFORM_VEC2);
+    }
+
+    static void Bake(Shader bakeShader, RenderTexture2D target) {
+        BeginTextureMode(target);
+            rlDisableColorBlend();
+            BeginShaderMode(bakeShader);
+                DrawRectangle(0, 0, target.texture.width, target.texture.height, WHITE);
+            EndShaderMode();
+            rlEnableColorBlend();
+        EndTextureMode();
+    }
+
+    // Bake with the other precision too and count the subpixels that land on a different view,
+    // mediump is what the Pi's interleaver has always run at
+    void ComparePrecision() {
+        Shader otherShader = LoadShaderSingleFile("./Shaders/quilt.shader",
+            "#define QUILT_BAKE_LUT\n" + GetPrecisionDefines(!highp));
+        RenderTexture2D other = LoadRenderTexture(width, height);
+        SetUniforms(otherShader, config, tiles, width, height);
+        Bake(otherShader, other);
+
+        Image a = LoadImageFromTexture(lut.texture);
+        Image b = LoadImageFromTexture(other.texture);
+        Color* pa = (Color*)a.data;
+        Color* pb = (Color*)b.data;
+        int differing = 0;
+        for (int i = 0; i < width * height; i++) {
+            differing += (pa[i].r != pb[i].r) + (pa[i].g != pb[i].g) + (pa[i].b != pb[i].b);
+        }
+        std::cout << "INFO: Interleaver mediump and highp LUTs differ in " << differing << " of "
+            << width * height * 3 << " subpixels\n";
+
+        UnloadImage(a);
+        UnloadImage(b);
+        UnloadRenderTexture(other);
+        UnloadShader(otherShader);
+    }
+public:
+    Interleaver(InterleaveMode mode, bool highp, int width, int height, const LKGConfig& config, std::string defines = "")
+        : mode(mode), highp(highp), width(width), height(height), config(config) {
+        if (mode == InterleaveMode::Lut)
+            defines += "#define QUILT_LUT\n";
+        else if (mode == InterleaveMode::LutCompare)
+            defines += "#define QUILT_LUT\n#define QUILT_LUT_COMPARE\n";
+        defines += GetPrecisionDefines(highp);
+
+        shader = LoadShaderSingleFile("./Shaders/quilt.shader", defines);
+        quiltTexLoc = GetShaderLocation(shader, "texture1");
+        lutLoc = GetShaderLocation(shader, "lut");
+
+        if (mode != InterleaveMode::Analytic) {
+            bakeShader = LoadShaderSingleFile("./Shaders/quilt.shader", "#define QUILT_BAKE_LUT\n" + GetPrecisionDefines(highp));
+            // 8 bits per channel holds up to 256 views
+            lut = LoadRenderTexture(width, height);
+        }
+    }
+    ~Interleaver() {
+        UnloadShader(shader);
+        if (mode == InterleaveMode::Analytic) return;
+        UnloadShader(bakeShader);
+        UnloadRenderTexture(lut);
+    }
+    Interleaver(const Interleaver&) = delete;
+    Interleaver& operator=(const Interleaver&) = delete;
+
+    void SetCalibration(const LKGConfig& config) {
+        this->config = config;
+        Update();
+    }
+    void SetTiles(std::pair<int, int> tiles) {
+        this->tiles = tiles;
+        Update();
+    }
+
+    // Push uniforms and re-bake the LUT, only needed when the calibration or tiles change
+    void Update() {
+        SetUniforms(shader, config, tiles, width, height);
+        if (mode == InterleaveMode::Analytic) return;
+
+        SetUniforms(bakeShader, config, tiles, width, height);
+        Bake(bakeShader, lut);
+        std::cout << "INFO: Baked interleaver LUT for " << tiles.first << "x" << tiles.second << " views\n";
+
+        if (mode == InterleaveMode::LutCompare)
+            ComparePrecision();
+    }
+
+    void Draw(Quilt* quilt) {
+        BeginShaderMode(shader);
+            quilt->SetShaderTexture(shader, quiltTexLoc);
+            if (mode != InterleaveMode::Analytic) {
+                // Unfiltered, the shader reads it with texelFetch
+                SetShaderValueTexture(shader, lutLoc, lut.texture);
+            }
+            DrawRectangle(0, 0, width, height, WHITE);
+        EndShaderMode();
+    }
+};
+
+#endif
@@ -5,6 +5,7 @@
 #include <cmath>
 #include <ctime>
 #include <stdio.h>
+#include <stdlib.h>
 #include <assert.h>
 #include <string>
 #include <regex>
@@ -13,17 +14,22 @@
 
 #include "config.h"
 #include "raylib_extensions.h"
+#include "renderer.h"
+#include "simulation.h"
+#include "sceneclock.h"
+#include "profiler.h"
+#include "governor.h"
+#include "headless.h"
 
-#include "scene.h"
-#include "clock.h"
-#include "pong.h"
-#include "graph.h"
-#include "tetris.h"
+#include "scenes.h"
+#include "scenemanager.h"
 
-int main()
+int main(int argc, char** argv)
 {
     // Initialization
     //--------------------------------------------------------------------------------------
+    AppOptions options(argc, argv);
+    BootTimer boot;
     
     // Window Config
     const int screenWidth = 1536;
@@ -31,109 +37,210 @@ int main()
     
     // Window
     // SetConfigFlags(FLAG_VSYNC_HINT | FLAG_MSAA_4X_HINT | FLAG_WINDOW_HIGHDPI);
-    InitWindow(screenWidth, screenHeight, "LKG Application");
+    HeadlessContext* headless = NULL;
+    if (options.headlessFrames > 0) {
+        headless = new HeadlessContext();
+        if (!headless->Init(screenWidth, screenHeight)) return 1;
+
+        // Same random numbers and wall clock on every run
+        SetRandomSeed(0);
+        setenv("TZ", "UTC", 1);
+        tzset();
+        fixedWallTime = 1000000000 + (std::time_t)options.fixedTime;
+    } else {
+        InitWindow(screenWidth, screenHeight, "LKG Application");
+    }
+    boot.Mark("window");
+    shaderCache.SetDirectory(options.shaderCache);
     
     // Fix Rectangle UVs (See: https://github.com/raysan5/raylib/issues/1730)
     Texture2D texture = { rlGetTextureIdDefault(), 1, 1, 1, PIXELFORMAT_UNCOMPRESSED_R8G8B8A8 };
     SetShapesTexture(texture, Rectangle{ 0.0f, 0.0f, 1.0f, 1.0f });
     // SetShapesTexture(rlGetTextureDefault(), Rectangle{ 0.0f, 0.0f, 1.0f, 1.0f });
     
-    //Load shaders
-    Shader lkgFragment = LoadShaderSingleFile("./Shaders/quilt.shader"); // Quilt shader
+    // Multiview must be enabled before scenes load their shaders
+    if (options.multiview) {
+        std::cout << "INFO: Using single pass multiview rendering\n";
+        InitMultiview();
+    }
+    boot.Mark("multiview");
 
     // Scene
-    //Scene* scene = new PongScene();
-    //Scene* scene = new ConsoleScene();
-    //Scene* scene = new GraphScene();
-    Scene* scene = new ClockScene();
-    //Scene* scene = new TetrisScene();
+    SceneManager* scenes = new SceneManager();
+    if (!scenes->Load(options.scene)) {
+        std::cout << "WARNING: Unknown scene '" << options.scene << "', using clock\n";
+        scenes->Load("clock");
+    }
+    Scene* scene = scenes->GetScene();
+    boot.Mark("scene");
 
     // LKG Config
     std::ifstream config_file("display.cfg");
     LKGConfig config(config_file);
 
-    std::pair<float, float> angleDistance = scene->GetAngleDistance();
-    std::pair<int, int> tiles = scene->GetTiles();
-    std::pair<int, int> tileRes = scene->GetTileResolution();
-    
-    // Initialize shader uniforms
-    int quiltTexLoc = GetShaderLocation(lkgFragment, "texture1");
-    int pitchLoc = GetShaderLocation(lkgFragment, "pitch");
-    SetShaderValue(lkgFragment, pitchLoc, &config.pitch, SHADER_UNIFORM_FLOAT);
-    int slopeLoc = GetShaderLocation(lkgFragment, "slope");
-    SetShaderValue(lkgFragment, slopeLoc, &config.slope, SHADER_UNIFORM_FLOAT);
-    int centerLoc = GetShaderLocation(lkgFragment, "center");
-    SetShaderValue(lkgFragment, centerLoc, &config.center, SHADER_UNIFORM_FLOAT);
-    int dpiLoc = GetShaderLocation(lkgFragment, "dpi");
-    SetShaderValue(lkgFragment, dpiLoc, &config.dpi, SHADER_UNIFORM_FLOAT);
-    int tileLoc = GetShaderLocation(lkgFragment, "tile");
-    float tile[2] = { tiles.first, tiles.second };
-    SetShaderValue(lkgFragment, tileLoc, tile, SHADER_UNIFORM_VEC2);
-    
-    // Render textures 8x6 (420x560)
-    RenderTexture2D quiltRT = LoadRenderTexture(tileRes.first * tiles.first, tileRes.second * tiles.second);
-    const int TILE_WIDTH = tileRes.first;
-    const int TILE_HEIGHT = tileRes.second;
-    const int TILE_COUNT = tiles.first * tiles.second;
-    
-    // Camera
-    Camera3D camera = { 0 };
-    camera.position = { 0, 0, angleDistance.second };
-    camera.target = { 0, 0, 0 };
-    camera.up = { 0, 1.0f, 0 };
-    camera.fovy = 17.0f;
-    camera.projection = CAMERA_PERSPECTIVE;
+    FrameProfiler* profiler = new FrameProfiler();
+    profiler->SetEnabled(scene->ShowFPS() || headless != NULL);
+    profiler->SetGpuFencing(options.gpuTiming);
+
+    QuiltRenderer* renderer = new QuiltRenderer(scene, options, config, screenWidth, screenHeight, *profiler);
+    boot.Mark("renderer");
+
+    if (headless != NULL) {
+        // Every frame shows the scene at the same time, Update isn't called so the state stays the initial one.
+        // No placeholders either, textures are loaded before the first frame
+        resources.FinishLoading();
+        boot.Mark("textures");
+        RenderTexture2D output = LoadRenderTexture(screenWidth, screenHeight);
+        for (int frame = 0; frame < options.headlessFrames; frame++) {
+            profiler->BeginFrame();
+            renderer->RenderQuilt(options.fixedTime, 1.0f);
+            BeginTextureMode(output);
+                ClearBackground(RAYWHITE);
+                renderer->Interleave();
+            EndTextureMode();
+            profiler->EndFrame();
+            if (frame == 0) {
+                glFinish();
+                boot.Mark("first frame");
+                boot.Report();
+            }
+        }
+
+        Image quiltImage = renderer->GetQuilt()->LoadQuiltImage();
+        Image outputImage = LoadImageFromRenderTexture(output);
+        ExportImage(quiltImage, (options.dumpPrefix + "_quilt.png").c_str());
+        ExportImage(outputImage, (options.dumpPrefix + "_output.png").c_str());
+        std::cout << "INFO: Headless: rendered " << options.headlessFrames << " frames of " << options.scene
+            << " at t=" << options.fixedTime << ", wrote " << options.dumpPrefix << "_quilt.png and "
+            << options.dumpPrefix << "_output.png\n";
+        profiler->Log();
+        UnloadImage(quiltImage);
+        UnloadImage(outputImage);
+        UnloadRenderTexture(output);
+
+        delete renderer;
+        delete profiler;
+        delete scenes;
+        resources.Unload();
+        UnloadInstanceStreams();
+        if (options.multiview) UnloadMultiview();
+        delete headless;
+        return 0;
+    }
+
+    QualityGovernor* governor = NULL;
+    if (options.governorFPS > 0) {
+        std::cout << "INFO: Adapting quilt quality for " << options.governorFPS << " FPS\n";
+        governor = new QualityGovernor(scene->GetTiles(), scene->GetTileResolution(), options.governorFPS, options.thermalPath);
+    }
     
+    SteadyTimeSource timeSource;
+    SceneClock sceneClock(&timeSource, options.tickRate);
+
+    auto startSimulation = [&] () -> SimulationThread* {
+        if (options.simulationRate <= 0) return NULL;
+        if (scene->SupportsThreadedUpdate()) return new SimulationThread(scene, &timeSource, options.simulationRate);
+        std::cout << "WARNING: Scene doesn't support a simulation thread, updating on the render thread\n";
+        return NULL;
+    };
+    SimulationThread* simulation = startSimulation();
+
+    // Read the next scene while this one is shown, so the first switch is as quick as the rest
+    scenes->Preload(scenes->GetNextSceneName());
+
+    bool wasIdle = false;
+
     //SetTargetFPS(30);               // Set our viewer to run at 60 frames-per-second
     //--------------------------------------------------------------------------------------
 
     // Main loop
     while (!WindowShouldClose())    // Detect window close button or ESC key
     {
+        profiler->BeginFrame();
+
+        // Scene switching: tab cycles through the scenes, the number keys pick one
+        if (IsKeyPressed(KEY_TAB)) scenes->SwitchTo(scenes->GetNextSceneName());
+        for (int i = 0; i < (int)SCENE_NAMES.size() && i < 9; i++) {
+            if (IsKeyPressed(KEY_ONE + i)) scenes->SwitchTo(SCENE_NAMES[i]);
+        }
+        if (scenes->Update()) {
+            // Nothing may use the previous scene once it's deleted
+            delete simulation;
+            Scene* previous = scenes->Swap();
+            scene = scenes->GetScene();
+            renderer->SetScene(scene);
+            delete previous;
+            simulation = startSimulation();
+
+            profiler->SetEnabled(scene->ShowFPS());
+            if (governor != NULL) {
+                delete governor;
+                governor = new QualityGovernor(scene->GetTiles(), scene->GetTileResolution(), options.governorFPS, options.thermalPath);
+                renderer->SetShadows(true);
+            }
+        }
+
+        // Textures loaded in the background, by the shown scene or the one being preloaded
+        resources.UploadTextures(options.uploadBudget);
+
         // Update
-    scene->Update();
+        if (simulation == NULL) {
+            ProfileScope scope(*profiler, ProfileStage::Update);
+            int steps = sceneClock.Advance();
+            for (int i = 0; i < steps; i++) scene->Update(sceneClock.GetStep());
+        }
+        // Idle frames include the idle wait, they say nothing about rendering cost
+        if (governor != NULL && !wasIdle && governor->Update(GetFrameTime())) {
+            renderer->SetQuality(governor->GetLevel().tiles, governor->GetLevel().tileRes);
+            renderer->SetShadows(governor->GetLevel().shadows);
+        }
         
         // Draw
         //----------------------------------------------------------------------------------
-        BeginTextureMode(quiltRT);
-            ClearBackground(scene->GetClearColor());
-            for (int i = TILE_COUNT - 1; i >= 0; i--) {
-                rlViewport((i%(int)tile[0])*TILE_WIDTH, (floor(i/(int)tile[0]))*TILE_HEIGHT, TILE_WIDTH, TILE_HEIGHT);
-                
-                float movementAmount = tan((config.viewCone/2.0f) * DEG2RAD) * angleDistance.second;
-                float offset = -movementAmount + ((movementAmount * 2)/TILE_COUNT) * i;
-                camera.position.x = offset;
-                camera.target.x = offset;
-                
-                BeginMode3DLG(camera, (float)TILE_WIDTH/(float)TILE_HEIGHT, -offset);
-                //Rotate stand angle
-                rlPushMatrix();
-                rlRotatef(angleDistance.first, 1, 0, 0);
-                    scene->Draw();
-                rlPopMatrix();
-                EndMode3D();
-            }
-        EndTextureMode();
+        bool quiltDirty = simulation != NULL
+            ? renderer->RenderQuilt(simulation->GetRenderTime(), simulation->GetAlpha())
+            : renderer->RenderQuilt(sceneClock.GetRenderTime(), sceneClock.GetAlpha());
+
+        // Nothing on screen changes either, only present at the idle rate
+        bool outputDirty = quiltDirty || scene->ShowFPS();
+        wasIdle = !outputDirty;
+        if (wasIdle) {
+            idleStats.idleFrames++;
+            WaitTime(1000.0f / options.idleFPS);
+        }
 
         BeginDrawing();
             ClearBackground(RAYWHITE);
-            BeginShaderMode(lkgFragment);
-                SetShaderValueTexture(lkgFragment, quiltTexLoc, quiltRT.texture);
-                DrawRectangle(0,0, 1536, 2048, WHITE);
-                //DrawTexture(quiltRT.texture, 0, 0, WHITE);
-            EndShaderMode();
-
-            if (scene->ShowFPS())
-                DrawFPSSize(50, 50, 90);
+            renderer->Interleave();
+
+            if (scene->ShowFPS()) {
+                int hudY = profiler->Draw(50, 50, 90);
+                DrawIdleStats(50, hudY, 45);
+            }
             //std::cout << GetFPS() << std::endl;
+        profiler->BeginStage(ProfileStage::Present, false);
         EndDrawing();
+        profiler->EndStage();
+        profiler->EndFrame();
+        if (!boot.IsReported()) {
+            boot.Mark("first frame");
+            boot.Report();
+        }
         //----------------------------------------------------------------------------------
     }
 
     // De-Initialization
     //--------------------------------------------------------------------------------------
-    UnloadRenderTexture(quiltRT);
-    UnloadShader(lkgFragment);
+    std::cout << "INFO: Skipped " << idleStats.quiltsSkipped << " of " << idleStats.frames << " quilt passes, "
+        << idleStats.idleFrames << " frames presented at the idle rate\n";
+    delete simulation;
+    delete governor;
+    delete renderer;
+    delete profiler;
+    delete scenes;
+    resources.Unload();
+    UnloadInstanceStreams();
+    if (options.multiview) UnloadMultiview();
 
     ClearDroppedFiles();
     CloseWindow();
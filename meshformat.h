@@ -0,0 +1,47 @@
+#ifndef MESHFORMAT_H
+#define MESHFORMAT_H
+
+#include <cstdint>
+
+// Preprocessed meshes (.lkgm), written by Tools/mesh_convert.cpp and loaded by LoadPackedMesh.
+// Everything is laid out as GL takes it, loading maps the file and uploads the buffers as they are.
+//
+// File: MeshFileHeader, lodCount MeshFileLODs, then each LOD's vertices and indices at their offsets.
+// LOD 0 is the full mesh, each further one has fewer triangles. Indices are in vertex cache order,
+// vertices in the order the indices first use them.
+
+#define MESH_FILE_VERSION 1
+#define MESH_FILE_MAX_LODS 8
+
+struct MeshFileHeader {
+    char magic[4];          // "LKGM"
+    uint32_t version;
+    uint32_t lodCount;
+    uint32_t vertexStride;  // sizeof(PackedVertex)
+    // Source positions are center + position*extent. One extent for every axis, so normals stay unskewed
+    float center[3];
+    float extent;
+    float radius;           // Bounding sphere of the quantized positions, around the origin
+    uint32_t reserved;
+};
+
+struct MeshFileLOD {
+    uint32_t vertexCount;
+    uint32_t indexCount;
+    uint32_t indexSize;     // 2 bytes, 4 when there are more vertices than 16 bits can index
+    float detail;           // Fraction of LOD 0's triangles
+    uint64_t vertexOffset;  // From the start of the file, 16 byte aligned
+    uint64_t indexOffset;
+};
+
+struct PackedVertex {
+    int16_t position[4];    // snorm, w unused
+    int8_t normal[4];       // snorm, w unused
+    uint16_t texcoord[2];   // unorm
+};
+
+static_assert(sizeof(MeshFileHeader) == 40, "MeshFileHeader is read from disk as is");
+static_assert(sizeof(MeshFileLOD) == 32, "MeshFileLOD is read from disk as is");
+static_assert(sizeof(PackedVertex) == 16, "PackedVertex is uploaded as is");
+
+#endif
@@ -0,0 +1,63 @@
+#include "raylib.h"
+#include "raymath.h"
+#include "rlgl.h"
+
+#include <cmath>
+#include <string>
+#include <iostream>
+
+#include "scene.h"
+#include "raylib_extensions.h"
+#include "resources.h"
+
+// A preprocessed mesh (Models/gameboy.lkgm, see mesh_convert) turning in place, drawn at the level
+// of detail the quilt's tile resolution needs
+class ModelScene : public Scene
+{
+private:
+    Shader litShader;
+    Material litMaterial;
+    Shader shadowShader;
+    ShadowPass shadow;
+
+    PackedMesh gameboy;
+public:
+    ModelScene() {
+        std::cout << "[INITIALIZING SCENE]: Model" << std::endl;
+
+        litShader = resources.AcquireShader("./Shaders/lit_instanced.shader", "#define COMPACT_INSTANCE\n"); // Lit shader
+        litMaterial = LoadMaterialDefault(); // Lit material
+        litMaterial.shader = litShader;
+
+        shadowShader = resources.AcquireShader("./Shaders/lit_instanced.shader", "#define COMPACT_INSTANCE\n#define SHADOW_PASS\n"); // Shadow shader
+        shadow.material = LoadMaterialDefault(); // Shadow material
+        shadow.material.shader = shadowShader;
+        shadow.plane = PlanarShadow{ Vector3{0.0f, -3.0f, 22.0f}, -2.0f };
+
+        gameboy = resources.AcquirePackedMesh("./Models/gameboy.lkgm");
+    }
+    ~ModelScene() {
+        resources.ReleaseShader(litShader);
+        resources.ReleaseShader(shadowShader);
+        resources.ReleasePackedMesh(gameboy);
+        UnloadMaterialMaps(litMaterial);
+        UnloadMaterialMaps(shadow.material);
+    }
+    void Activate() {
+        SetShadowPassUniforms(shadow, Vector3{0.8f, 0.8f, 0.8f});
+    }
+    void Update(float deltaTime) { }
+    bool SupportsThreadedUpdate() { return true; }
+    void Draw(DrawList& list, double time, float alpha) {
+        if (!gameboy.IsLoaded()) return;
+        float gameTime = time * 0.5f;
+
+        Matrix transform = MatrixMultiply(gameboy.transform, MatrixScale(0.28f, 0.28f, 0.28f));
+        transform = MatrixMultiply(transform, MatrixRotateY(gameTime));
+        transform = MatrixMultiply(transform, MatrixRotateX(0.25f));
+        transform = MatrixMultiply(transform, MatrixTranslate(0, sinf(gameTime * 2.0f) * 0.1f, 0));
+        CompactInstance instance = ToCompactInstance(transform, Color{196, 195, 189, 255});
+
+        list.DrawInstances(gameboy.SelectLOD(list.GetTileResolution()), litMaterial, COMPACT_INSTANCE_LAYOUT, &instance, 1, &shadow);
+    }
+};
@@ -0,0 +1,126 @@
+#ifndef PACKEDMESH_H
+#define PACKEDMESH_H
+
+#include "raylib.h"
+#include "raymath.h"
+#include "rlgl.h"
+
+#include <string>
+#include <vector>
+#include <utility>
+#include <cstring>
+#include <iostream>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#include "meshformat.h"
+#include "raylib_extensions.h"
+
+// Tile pixels at which LOD 0 is needed, smaller tiles get the LOD with proportionally fewer triangles
+#define PACKED_MESH_FULL_DETAIL_PIXELS (420*560)
+
+// A preprocessed mesh (see meshformat.h) as LODs drawn through the instanced path, finest first
+struct PackedMesh {
+    std::string path;
+    std::vector<Mesh> lods;
+    std::vector<float> details;     // Fraction of LOD 0's triangles, per LOD
+    // From the quantized positions to the source mesh's, instance transforms are multiplied by it
+    Matrix transform = MatrixIdentity();
+
+    bool IsLoaded() const { return !lods.empty(); }
+
+    // The coarsest LOD with at least as many triangles per tile pixel as LOD 0 has at full detail
+    Mesh SelectLOD(std::pair<int, int> tileResolution) const {
+        float needed = (float)(tileResolution.first*tileResolution.second) / PACKED_MESH_FULL_DETAIL_PIXELS;
+        size_t lod = 0;
+        while (lod + 1 < lods.size() && details[lod + 1] >= needed) lod++;
+        return lods[lod];
+    }
+};
+
+// Ask the kernel to read the file ahead, safe to call from any thread (see ResourceCache::Prefetch)
+void PrefetchPackedMesh(const std::string& path)
+{
+    int fd = open(path.c_str(), O_RDONLY);
+    if (fd == -1) return;
+    posix_fadvise(fd, 0, 0, POSIX_FADV_WILLNEED);
+    close(fd);
+}
+
+// Maps the file and uploads each LOD's buffers straight from the mapping, nothing is parsed or converted.
+// Not loaded (see IsLoaded) when the file is missing or not a mesh file of this version
+PackedMesh LoadPackedMesh(const std::string& path)
+{
+    PackedMesh mesh;
+    mesh.path = path;
+
+    int fd = open(path.c_str(), O_RDONLY);
+    struct stat info;
+    if (fd == -1 || fstat(fd, &info) != 0 || (size_t)info.st_size < sizeof(MeshFileHeader)) {
+        std::cout << "WARNING: Couldn't load mesh '" << path << "', run mesh_convert (see README)\n";
+        if (fd != -1) close(fd);
+        return mesh;
+    }
+    size_t size = info.st_size;
+    const unsigned char *data = (const unsigned char *)mmap(NULL, size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (data == MAP_FAILED) {
+        std::cout << "WARNING: Couldn't map mesh '" << path << "'\n";
+        return mesh;
+    }
+
+    const MeshFileHeader *header = (const MeshFileHeader *)data;
+    const MeshFileLOD *table = (const MeshFileLOD *)(data + sizeof(MeshFileHeader));
+    bool valid = memcmp(header->magic, "LKGM", 4) == 0 && header->version == MESH_FILE_VERSION
+        && header->vertexStride == sizeof(PackedVertex) && header->lodCount > 0 && header->lodCount <= MESH_FILE_MAX_LODS
+        && sizeof(MeshFileHeader) + header->lodCount*sizeof(MeshFileLOD) <= size;
+    for (uint32_t i = 0; valid && i < header->lodCount; i++) {
+        const MeshFileLOD& lod = table[i];
+        valid = (lod.indexSize == 2 || lod.indexSize == 4) && lod.indexCount % 3 == 0
+            && lod.vertexOffset + (uint64_t)lod.vertexCount*sizeof(PackedVertex) <= size
+            && lod.indexOffset + (uint64_t)lod.indexCount*lod.indexSize <= size;
+    }
+    if (!valid) {
+        std::cout << "WARNING: '" << path << "' isn't a version " << MESH_FILE_VERSION << " mesh file, convert it again\n";
+        munmap((void *)data, size);
+        return mesh;
+    }
+
+    for (uint32_t i = 0; i < header->lodCount; i++) {
+        const MeshFileLOD& lod = table[i];
+        Mesh lodMesh = { 0 };
+        lodMesh.vertexCount = lod.vertexCount;
+        lodMesh.triangleCount = lod.indexCount/3;
+        // raylib's MAX_MESH_VERTEX_BUFFERS, UnloadMesh frees them all
+        lodMesh.vboId = (unsigned int *)RL_CALLOC(7, sizeof(unsigned int));
+        lodMesh.vboId[0] = rlLoadVertexBuffer(data + lod.vertexOffset, lod.vertexCount*sizeof(PackedVertex), false);
+        lodMesh.vboId[6] = rlLoadVertexBufferElement(data + lod.indexOffset, lod.indexCount*lod.indexSize, false);
+
+        packedMeshes[lodMesh.vboId[0]] = PackedMeshFormat{
+            lod.indexSize == 2 ? (unsigned int)GL_UNSIGNED_SHORT : (unsigned int)GL_UNSIGNED_INT, header->radius };
+        mesh.lods.push_back(lodMesh);
+        mesh.details.push_back(lod.detail);
+    }
+    mesh.transform = MatrixMultiply(MatrixScale(header->extent, header->extent, header->extent),
+        MatrixTranslate(header->center[0], header->center[1], header->center[2]));
+
+    std::cout << "INFO: Loaded mesh '" << path << "' (" << mesh.lods.size() << " LODs, "
+        << mesh.lods[0].triangleCount << " triangles)\n";
+    munmap((void *)data, size);
+    return mesh;
+}
+
+void UnloadPackedMesh(PackedMesh& mesh)
+{
+    for (Mesh& lod : mesh.lods) {
+        packedMeshes.erase(lod.vboId[0]);
+        UnloadInstanceStreamsOf(lod.vboId[0], 0);
+        UnloadMesh(lod);
+    }
+    mesh.lods.clear();
+    mesh.details.clear();
+}
+
+#endif
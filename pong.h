@@ -11,8 +11,11 @@
 
 #include "scene.h"
 #include "raylib_extensions.h"
+#include "resources.h"
 
 #define BALL_SPEED 3.5f
+#define PADDLE_SPEED 2.0f
+#define PADDLE_Y 2.25f      // Face of the paddles the ball bounces off
 
 class PongScene : public Scene
 {
@@ -24,51 +27,72 @@ private:
     int player1Score = 0;
     int player2Score = 0;
 
-    float roundStartTime;
+    float roundTime = 0.0f;  // Simulation time since the round started
+
+    // Positions before the last step, Draw interpolates from them
+    float previousPaddle1X = 0.0f;
+    float previousPaddle2X = 0.0f;
+    Vector3 previousPongPosition = Vector3{0,0,0};
+
+    // Everything Draw reads, published at the end of every Update
+    struct PongSnapshot {
+        float previousPaddle1X;
+        float previousPaddle2X;
+        Vector3 previousPongPosition;
+        float paddle1X;
+        float paddle2X;
+        Vector3 pongPosition;
+        int player1Score;
+        int player2Score;
+    };
+    SnapshotBuffer<PongSnapshot> snapshots;
+    void PublishSnapshot() {
+        snapshots.Write() = PongSnapshot{ previousPaddle1X, previousPaddle2X, previousPongPosition,
+            paddle1X, paddle2X, pongPosition, player1Score, player2Score };
+        snapshots.Publish();
+    }
+
+    // Whether the ball crossed a paddle's face during the step from 'from' to pongPosition.
+    // Checked on the whole step rather than the end position, so the ball can't pass through
+    bool HitsPaddle(Vector3 from, float paddleX, float faceY) {
+        if (pongPosition.y == from.y) return false;
+        float t = (faceY - from.y) / (pongPosition.y - from.y);
+        if (t < 0.0f || t > 1.0f) return false;
+        float x = Lerp(from.x, pongPosition.x, t);
+        return x > paddleX - 0.625f && x < paddleX + 0.625f;
+    }
 
     Shader litShader;
     Material litMaterial;
+    Shader shadowShader;
+    ShadowPass shadow;
     Mesh cubeMesh;
 
     Shader textShader;
     Material textMaterial;
+    TextureHandle fontAtlas;    // Placeholder until loaded, read into textMaterial every Draw
     Mesh quadMesh;
 public:
     PongScene() {
         std::cout << "[INITIALIZING SCENE]: Pong" << std::endl;
 
-        Vector3 shadowColor = Vector3{0.0f, 0.0f, 0.0f};
-        Vector3 lightPos = Vector3{0.0f, -3.0f, 22.0f};
-        float planeZ = -2.0f;
-
         // LIT SHADER ----------
-        litShader = LoadShaderSingleFile("./Shaders/lit_instanced.shader");
-        litShader.locs[SHADER_LOC_MATRIX_MODEL] = GetShaderLocationAttrib(litShader, "matModel");
-        litShader.locs[SHADER_LOC_COLOR_DIFFUSE] = GetShaderLocationAttrib(litShader, "colDiffuse");
-        litShader.locs[SHADER_LOC_MATRIX_VIEW] = GetShaderLocation(litShader, "matView");
-        litShader.locs[SHADER_LOC_MATRIX_PROJECTION] = GetShaderLocation(litShader, "matProjection");
-
-        SetShaderValue(litShader, GetShaderLocation(litShader, "shadowColor"), &shadowColor, SHADER_UNIFORM_VEC3);
-        SetShaderValue(litShader, GetShaderLocation(litShader, "lightPos"), &lightPos, SHADER_UNIFORM_VEC3);
-        SetShaderValue(litShader, GetShaderLocation(litShader, "planeZ"), &planeZ, SHADER_UNIFORM_FLOAT);
-
+        litShader = resources.AcquireShader("./Shaders/lit_instanced.shader", "#define COMPACT_INSTANCE\n");
         litMaterial = LoadMaterialDefault(); // Lit material
         litMaterial.shader = litShader;
 
-        // TEXT SHADER ----------
-        textShader = LoadShaderSingleFile("./Shaders/text.shader");
-        textShader.locs[SHADER_LOC_MATRIX_MODEL] = GetShaderLocationAttrib(textShader, "matModel");
-        textShader.locs[SHADER_LOC_COLOR_DIFFUSE] = GetShaderLocationAttrib(textShader, "colDiffuse");
-        textShader.locs[SHADER_LOC_MATRIX_VIEW] = GetShaderLocation(textShader, "matView");
-        textShader.locs[SHADER_LOC_MATRIX_PROJECTION] = GetShaderLocation(textShader, "matProjection");
+        // SHADOW SHADER ----------
+        shadowShader = resources.AcquireShader("./Shaders/lit_instanced.shader", "#define COMPACT_INSTANCE\n#define SHADOW_PASS\n");
+        shadow.material = LoadMaterialDefault(); // Shadow material
+        shadow.material.shader = shadowShader;
+        shadow.plane = PlanarShadow{ Vector3{0.0f, -3.0f, 22.0f}, -2.0f };
 
-        Vector2 atlasSize = Vector2{15, 8};
-        SetShaderValue(textShader, GetShaderLocation(textShader, "atlasSize"), &atlasSize, SHADER_UNIFORM_VEC2);
-
-        textShader.locs[SHADER_LOC_MAP_ALBEDO] = GetShaderLocation(textShader, "texture1");
+        // TEXT SHADER ----------
+        textShader = resources.AcquireShader("./Shaders/text.shader");
 
         MaterialMap fontAtlasMap = { 0 };
-        fontAtlasMap.texture = LoadTexture("./Textures/FontAtlas.png");
+        fontAtlas = resources.AcquireTexture("./Textures/FontAtlas.png");
+        fontAtlasMap.texture = fontAtlas.Get();
         fontAtlasMap.color = WHITE;
 
         textMaterial = LoadMaterialDefault(); // Text material
@@ -76,37 +100,56 @@ public:
         textMaterial.maps[0] = fontAtlasMap;
 
         // MESHES ----------
-        cubeMesh = GenMeshCube(1.0f, 1.0f, 1.0f);
-        quadMesh = GenMeshPlaneY(0.5f, 1.0f, 1, 1);
+        cubeMesh = resources.AcquireMesh("cube 1", [] { return GenMeshCube(1.0f, 1.0f, 1.0f); });
+        quadMesh = resources.AcquireMesh("planeY 0.5 1", [] { return GenMeshPlaneY(0.5f, 1.0f, 1, 1); });
         
         // MISC ----------
-        roundStartTime = GetTime();
+        PublishSnapshot();
     }
     ~PongScene() {
-        UnloadShader(litShader);
+        resources.ReleaseShader(litShader);
+        resources.ReleaseShader(shadowShader);
+        resources.ReleaseShader(textShader);
+        resources.ReleaseTexture(fontAtlas);
+        resources.ReleaseMesh(cubeMesh);
+        resources.ReleaseMesh(quadMesh);
+        UnloadMaterialMaps(litMaterial);
+        UnloadMaterialMaps(shadow.material);
+        UnloadMaterialMaps(textMaterial);
     }
-    void Update() {
-        float deltaTime = GetFrameTime();
+    void Activate() {
+        SetShadowPassUniforms(shadow, Vector3{0.0f, 0.0f, 0.0f});
+        Vector2 atlasSize = Vector2{15, 8};
+        SetShaderValue(textShader, GetShaderLocation(textShader, "atlasSize"), &atlasSize, SHADER_UNIFORM_VEC2);
+    }
+    void Update(float deltaTime) {
+        previousPaddle1X = paddle1X;
+        previousPaddle2X = paddle2X;
+        previousPongPosition = pongPosition;
+
         if (IsKeyDown(KEY_A)) {
-           paddle1X -= deltaTime * 2.0f;
+           paddle1X -= deltaTime * PADDLE_SPEED;
         }
         if (IsKeyDown(KEY_D)) {
-           paddle1X += deltaTime * 2.0f;
+           paddle1X += deltaTime * PADDLE_SPEED;
         }
         if (IsKeyDown(KEY_J)) {
-           paddle2X -= deltaTime * 2.0f;
+           paddle2X -= deltaTime * PADDLE_SPEED;
         }
         if (IsKeyDown(KEY_L)) {
-           paddle2X += deltaTime * 2.0f;
+           paddle2X += deltaTime * PADDLE_SPEED;
         }
-        if (GetTime() - roundStartTime > 1.0f)
+        roundTime += deltaTime;
+        if (roundTime > 1.0f)
             pongPosition = Vector3Add(pongPosition, Vector3Scale(pongVelocity, deltaTime));
-        //Paddle bouncing
-        if (pongPosition.y < -2.25f && pongPosition.x > paddle1X - 0.625f && pongPosition.x < paddle1X + 0.625f) {
+        //Paddle bouncing, only towards the paddle so the ball can't bounce twice
+        if (pongVelocity.y < 0 && HitsPaddle(previousPongPosition, paddle1X, -PADDLE_Y)) {
             pongVelocity.y = -pongVelocity.y;
+            pongPosition.y = -2.0f * PADDLE_Y - pongPosition.y;
         }
-        if (pongPosition.y > 2.25f && pongPosition.x > paddle2X - 0.625f && pongPosition.x < paddle2X + 0.625f) {
+        if (pongVelocity.y > 0 && HitsPaddle(previousPongPosition, paddle2X, PADDLE_Y)) {
             pongVelocity.y = -pongVelocity.y;
+            pongPosition.y = 2.0f * PADDLE_Y - pongPosition.y;
         }
         //Off screen
         if (pongPosition.y < -4.0f || pongPosition.y > 4.0f) {
@@ -118,37 +161,38 @@ public:
             pongVelocity = Vector3{GetRandomFloat(-1.0f, 1.0f),GetRandomValue(0, 1) == 0 ? BALL_SPEED : -BALL_SPEED, 0};
             paddle1X = 0;
             paddle2X = 0;
-            roundStartTime = GetTime();
+            roundTime = 0.0f;
+            // Don't interpolate across the reset
+            previousPaddle1X = paddle1X;
+            previousPaddle2X = paddle2X;
+            previousPongPosition = pongPosition;
         }
         //Wall bouncing
         if (pongPosition.x < -2.0f || pongPosition.x > 2.0f) pongVelocity.x = -pongVelocity.x;
+
+        PublishSnapshot();
     }
-    void Draw() {
+    bool SupportsThreadedUpdate() { return true; }
+    void Draw(DrawList& list, double time, float alpha) {
+        textMaterial.maps[0].texture = fontAtlas.Get();
+        const PongSnapshot& state = snapshots.Acquire();
+        float paddle1X = Lerp(state.previousPaddle1X, state.paddle1X, alpha);
+        float paddle2X = Lerp(state.previousPaddle2X, state.paddle2X, alpha);
+        Vector3 pongPosition = Vector3Lerp(state.previousPongPosition, state.pongPosition, alpha);
         rlTranslatef(0, 0, 0.25f);
-        float gameTime = GetTime();// * 0.25f;
+        float gameTime = time;// * 0.25f;
 
-        std::time_t now = time(nullptr);
+        std::time_t now = GetWallTime();
         std::tm calender_time = *std::localtime( std::addressof(now) ) ;
 
-        Matrix transforms[10];
-        Vector4 colors[10];
-        int instanceIdx = 0;
-
-        Matrix textTransforms[20];
-        Vector4 textColors[20];
-        int textInstanceIdx = 0;
+        InstanceBatch<CompactInstance> instances(list.GetArena());
+        InstanceBatch<ModelInstance> glyphs(list.GetArena());
 
         auto drawCube = [&] (Matrix m, Color c) {
-            c.a = 0;
-            colors[instanceIdx] = ColorNormalize(c);
-            transforms[instanceIdx++] = m;
-            c.a = 255;
-            colors[instanceIdx] = ColorNormalize(c);
-            transforms[instanceIdx++] = m;
+            instances.Push(ToCompactInstance(m, c));
         };
         auto drawChar = [&] (Matrix m, Color col, char c) {
-            textColors[textInstanceIdx] = ColorNormalize(Color{col.r,col.g,col.b,c-32});
-            textTransforms[textInstanceIdx++] = m;
+            glyphs.Push(ToModelInstance(m, ColorNormalize(Color{col.r,col.g,col.b,c-32})));
         };
         auto drawText = [&] (std::string text, Color col, float scale) {
             rlPushMatrix();
@@ -180,33 +224,33 @@ public:
             drawCube(rlGetMatrixTransform(), RAYWHITE);
         rlPopMatrix();
 
-        DrawMeshInstancedC(cubeMesh, litMaterial, transforms, colors, instanceIdx);
+        list.DrawInstances(cubeMesh, litMaterial, COMPACT_INSTANCE_LAYOUT, instances, &shadow);
 
         //Score
         //Player 1
         rlPushMatrix();
         rlTranslatef(-1.6f, 0.5f, -0.5f);
-            drawChar(rlGetMatrixTransform(), Color{255,255,255,255}, '0' + player2Score);
+            drawChar(rlGetMatrixTransform(), Color{255,255,255,255}, '0' + state.player2Score);
         rlTranslatef(0, 0, -0.5f);
-            drawChar(rlGetMatrixTransform(), Color{215,255,255,255}, '0' + player2Score);
+            drawChar(rlGetMatrixTransform(), Color{215,255,255,255}, '0' + state.player2Score);
         rlTranslatef(0, 0, -0.5f);
-            drawChar(rlGetMatrixTransform(), Color{175,255,255,255}, '0' + player2Score);
+            drawChar(rlGetMatrixTransform(), Color{175,255,255,255}, '0' + state.player2Score);
         rlTranslatef(0, 0, -0.5f);
-            drawChar(rlGetMatrixTransform(), Color{135,255,255,255}, '0' + player2Score);
+            drawChar(rlGetMatrixTransform(), Color{135,255,255,255}, '0' + state.player2Score);
         rlPopMatrix();
         //Player 2
         rlPushMatrix();
         rlTranslatef(1.6f, -0.5f, -0.5f);
-            drawChar(rlGetMatrixTransform(), Color{255,255,255,255}, '0' + player1Score);
+            drawChar(rlGetMatrixTransform(), Color{255,255,255,255}, '0' + state.player1Score);
         rlTranslatef(0, 0, -0.5f);
-            drawChar(rlGetMatrixTransform(), Color{255,215,255,255}, '0' + player1Score);
+            drawChar(rlGetMatrixTransform(), Color{255,215,255,255}, '0' + state.player1Score);
         rlTranslatef(0, 0, -0.5f);
-            drawChar(rlGetMatrixTransform(), Color{255,175,255,255}, '0' + player1Score);
+            drawChar(rlGetMatrixTransform(), Color{255,175,255,255}, '0' + state.player1Score);
         rlTranslatef(0, 0, -0.5f);
-            drawChar(rlGetMatrixTransform(), Color{255,135,255,255}, '0' + player1Score);
+            drawChar(rlGetMatrixTransform(), Color{255,135,255,255}, '0' + state.player1Score);
         rlPopMatrix();
 
-        DrawMeshInstancedC(quadMesh, textMaterial, textTransforms, textColors, textInstanceIdx);
+        list.DrawInstances(quadMesh, textMaterial, MODEL_INSTANCE_LAYOUT, glyphs);
     }
 
     Color GetClearColor() {
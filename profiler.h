@@ -0,0 +1,374 @@
+#ifndef PROFILER_H
+#define PROFILER_H
+
+#include "raylib.h"
+#include "rlgl.h"
+
+#include <GLES3/gl3.h>
+
+#include <cmath>
+#include <chrono>
+#include <string>
+#include <vector>
+#include <utility>
+#include <cstring>
+#include <algorithm>
+
+#include "raylib_extensions.h"
+
+// From GL_EXT_disjoint_timer_query, used with the core ES3 query functions
+#define GL_TIME_ELAPSED_EXT 0x88BF
+#define GL_GPU_DISJOINT_EXT 0x8FBB
+
+// Min/avg/p99 milliseconds (or counts) over the rolling window
+struct ProfileStats {
+    float min;
+    float avg;
+    float p99;
+};
+
+enum class ProfileStage : unsigned char {
+    Update,     // Scene::Update (when it runs on the render thread)
+    Build,      // Scene::Draw into the draw list, dirty tracking
+    Upload,     // Instance buffers
+    Quilt,      // All views (or key views + synthesis)
+    Interleave, // Lenticular pass to the screen
+    Present,    // EndDrawing, includes waiting for vsync
+    Count
+};
+
+// Per stage CPU and GPU timings over a rolling window, drawn as the overlay when Scene::ShowFPS.
+// GPU times come from GL_EXT_disjoint_timer_query when the driver exposes it. Otherwise GPU stages are
+// only timed when fencing is on (see SetGpuFencing): each stage is then fenced and waited on, which
+// serializes CPU and GPU, so those times are upper bounds (shown as "~") and the frame rate drops.
+class FrameProfiler {
+private:
+    static const int WINDOW = 120;  // Frames, by default
+    static const int LATENCY = 4;   // Frames of timer queries in flight
+    static const int STAGES = (int)ProfileStage::Count;
+
+    // Samples in milliseconds, oldest overwritten first
+    struct RollingStats {
+        std::vector<float> samples = std::vector<float>(WINDOW);
+        mutable std::vector<float> sorted = std::vector<float>(WINDOW);    // Scratch for P99
+        int count = 0;
+        int next = 0;
+
+        void SetWindow(int window) {
+            samples.assign(window, 0.0f);
+            sorted.assign(window, 0.0f);
+            Clear();
+        }
+        void Add(float sample) {
+            samples[next] = sample;
+            next = (next + 1) % (int)samples.size();
+            count = std::min(count + 1, (int)samples.size());
+        }
+        float Min() const { return count == 0 ? 0.0f : *std::min_element(samples.begin(), samples.begin() + count); }
+        float Avg() const {
+            float sum = 0.0f;
+            for (int i = 0; i < count; i++) sum += samples[i];
+            return count == 0 ? 0.0f : sum / count;
+        }
+        void Clear() {
+            count = 0;
+            next = 0;
+        }
+        ProfileStats GetStats() const { return ProfileStats{ Min(), Avg(), P99() }; }
+        float P99() const {
+            if (count == 0) return 0.0f;
+            std::copy(samples.begin(), samples.begin() + count, sorted.begin());
+            int index = std::min(count - 1, (int)std::ceil(count * 0.99f) - 1);
+            std::nth_element(sorted.begin(), sorted.begin() + index, sorted.begin() + count);
+            return sorted[index];
+        }
+    };
+
+    using Clock = std::chrono::steady_clock;
+
+    bool enabled = false;
+    bool timerQueries = false;
+    bool fencing = false;       // Time GPU stages with fences when there are no timer queries
+
+    RollingStats cpu[STAGES];
+    RollingStats gpu[STAGES];
+    bool gpuStage[STAGES] = { false };  // Stage submitted GPU work this frame
+    Clock::time_point stageStart;
+    ProfileStage current = ProfileStage::Count;
+
+    RollingStats frame;
+    Clock::time_point frameStart;
+
+    RollingStats drawCalls;
+    RollingStats instances;
+    RollingStats culled;
+    RollingStats uploadBytes;
+    int buffersCreated = 0;
+    long arenaHighWater = 0;    // Frame arena bytes, since the last Reset
+    int arenaBlocks = 0;        // Allocated by the frame arena so far
+    int arenaBlocksAtReset = 0;
+    bool arenaGrew = false;     // Last frame
+
+    // Timer queries, one per stage per frame in flight
+    GLuint queries[LATENCY][STAGES] = { { 0 } };
+    bool pending[LATENCY][STAGES] = { { false } };
+    int queryFrame = 0;
+
+    static bool HasExtension(const char* name) {
+        GLint count = 0;
+        glGetIntegerv(GL_NUM_EXTENSIONS, &count);
+        for (int i = 0; i < count; i++) {
+            if (strcmp((const char*)glGetStringi(GL_EXTENSIONS, i), name) == 0) return true;
+        }
+        return false;
+    }
+
+    static float Milliseconds(Clock::duration duration) {
+        return std::chrono::duration<float, std::milli>(duration).count();
+    }
+
+    // Collect a frame's queries, without waiting only if they're all available
+    void ReadQueries(int slot, bool wait) {
+        GLint disjoint = 0;
+        glGetIntegerv(GL_GPU_DISJOINT_EXT, &disjoint);
+
+        for (int stage = 0; stage < STAGES; stage++) {
+            if (!pending[slot][stage]) continue;
+
+            GLuint available = GL_FALSE;
+            glGetQueryObjectuiv(queries[slot][stage], GL_QUERY_RESULT_AVAILABLE, &available);
+            if (!available && !wait) return;
+
+            GLuint nanoseconds = 0;
+            glGetQueryObjectuiv(queries[slot][stage], GL_QUERY_RESULT, &nanoseconds);
+            pending[slot][stage] = false;
+            // Frequency changes etc. make the results meaningless
+            if (!disjoint) gpu[stage].Add(nanoseconds / 1000000.0f);
+        }
+    }
+public:
+    // window: frames the stats cover, e.g. every measured frame of a bench run
+    FrameProfiler(int window = WINDOW) {
+        for (int stage = 0; stage < STAGES; stage++) {
+            cpu[stage].SetWindow(window);
+            gpu[stage].SetWindow(window);
+        }
+        for (RollingStats* stats : { &frame, &drawCalls, &instances, &culled, &uploadBytes }) stats->SetWindow(window);
+
+        timerQueries = HasExtension("GL_EXT_disjoint_timer_query");
+        if (timerQueries) {
+            glGenQueries(LATENCY * STAGES, &queries[0][0]);
+            std::cout << "INFO: Profiling GPU stages with timer queries\n";
+        } else {
+            std::cout << "INFO: No GPU timer queries, GPU stages are only timed with --gpu-timing\n";
+        }
+    }
+    ~FrameProfiler() {
+        if (timerQueries) glDeleteQueries(LATENCY * STAGES, &queries[0][0]);
+    }
+    FrameProfiler(const FrameProfiler&) = delete;
+    FrameProfiler& operator=(const FrameProfiler&) = delete;
+
+    // Nothing is measured (or waited on) while disabled
+    void SetEnabled(bool enabled) { this->enabled = enabled; }
+    bool IsEnabled() { return enabled; }
+    // Without timer queries, wait for the GPU after every GPU stage to time it. Stalls every frame,
+    // only for runs that are there to be measured (--gpu-timing, lkg_bench)
+    void SetGpuFencing(bool fencing) { this->fencing = fencing; }
+
+    void BeginFrame() {
+        if (!enabled) return;
+        frameStart = Clock::now();
+        // This frame reuses the queries from LATENCY frames ago, usually long finished
+        if (timerQueries) ReadQueries(queryFrame, true);
+    }
+    void EndFrame() {
+        if (!enabled) return;
+        frame.Add(Milliseconds(Clock::now() - frameStart));
+        drawCalls.Add(instanceStats.drawCalls);
+        instances.Add(instanceStats.instances);
+        culled.Add(instanceStats.instancesCulled);
+        uploadBytes.Add(instanceStats.bytesUploaded);
+        buffersCreated = instanceStats.buffersCreated;
+        arenaHighWater = std::max(arenaHighWater, instanceStats.arenaBytes);
+        arenaGrew = instanceStats.arenaBlocksAllocated != arenaBlocks;
+        arenaBlocks = instanceStats.arenaBlocksAllocated;
+
+        if (timerQueries) queryFrame = (queryFrame + 1) % LATENCY;
+    }
+
+    // gpuWork: the stage submits GL commands worth timing on the GPU
+    void BeginStage(ProfileStage stage, bool gpuWork) {
+        if (!enabled) return;
+        current = stage;
+        gpuWork = gpuWork && (timerQueries || fencing);
+        gpuStage[(int)stage] = gpuWork;
+        if (gpuWork) {
+            if (timerQueries) {
+                glBeginQuery(GL_TIME_ELAPSED_EXT, queries[queryFrame][(int)stage]);
+            } else {
+                // Start from an idle GPU so the fence below only covers this stage
+                rlDrawRenderBatchActive();
+                glFinish();
+            }
+        }
+        stageStart = Clock::now();
+    }
+    void EndStage() {
+        if (!enabled || current == ProfileStage::Count) return;
+        int stage = (int)current;
+        cpu[stage].Add(Milliseconds(Clock::now() - stageStart));
+
+        if (gpuStage[stage]) {
+            rlDrawRenderBatchActive();
+            if (timerQueries) {
+                glEndQuery(GL_TIME_ELAPSED_EXT);
+                pending[queryFrame][stage] = true;
+            } else {
+                GLsync fence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+                glClientWaitSync(fence, GL_SYNC_FLUSH_COMMANDS_BIT, 100000000);
+                glDeleteSync(fence);
+                gpu[stage].Add(Milliseconds(Clock::now() - stageStart));
+            }
+        }
+        current = ProfileStage::Count;
+    }
+
+    // Start a new window, e.g. after warming up
+    void Reset() {
+        for (int stage = 0; stage < STAGES; stage++) {
+            cpu[stage].Clear();
+            gpu[stage].Clear();
+        }
+        frame.Clear();
+        drawCalls.Clear();
+        instances.Clear();
+        culled.Clear();
+        uploadBytes.Clear();
+        arenaHighWater = 0;
+        arenaBlocksAtReset = arenaBlocks;
+    }
+
+    bool HasTimerQueries() { return timerQueries; }
+    ProfileStats GetFrameStats() { return frame.GetStats(); }
+    ProfileStats GetCpuStats(ProfileStage stage) { return cpu[(int)stage].GetStats(); }
+    ProfileStats GetGpuStats(ProfileStage stage) { return gpu[(int)stage].GetStats(); }
+    ProfileStats GetDrawCallStats() { return drawCalls.GetStats(); }
+    ProfileStats GetInstanceStats() { return instances.GetStats(); }
+    ProfileStats GetCulledStats() { return culled.GetStats(); }
+    ProfileStats GetUploadStats() { return uploadBytes.GetStats(); }
+    long GetArenaHighWater() { return arenaHighWater; }
+    // Blocks the frame arena allocated since the last Reset, 0 once a scene's frames fit
+    int GetArenaBlocksAllocated() { return arenaBlocks - arenaBlocksAtReset; }
+
+    static const char* GetStageName(ProfileStage stage) {
+        switch (stage) {
+            case ProfileStage::Update: return "UPDATE";
+            case ProfileStage::Build: return "BUILD";
+            case ProfileStage::Upload: return "UPLOAD";
+            case ProfileStage::Quilt: return "QUILT";
+            case ProfileStage::Interleave: return "INTERLEAVE";
+            case ProfileStage::Present: return "PRESENT";
+            default: return "";
+        }
+    }
+
+    std::string GetFrameLine() {
+        return TextFormat("%2i FPS %.1f/%.1f/%.1f MS", GetFPS(), frame.Min(), frame.Avg(), frame.P99());
+    }
+    // Empty for stages that didn't run
+    std::string GetStageLine(ProfileStage stage) {
+        const RollingStats& stageCpu = cpu[(int)stage];
+        const RollingStats& stageGpu = gpu[(int)stage];
+        if (stageCpu.count == 0) return "";
+
+        std::string line = TextFormat("%-10s CPU %.1f/%.1f/%.1f", GetStageName(stage),
+            stageCpu.Min(), stageCpu.Avg(), stageCpu.P99());
+        if (stageGpu.count > 0)
+            line += TextFormat("  %s %.1f/%.1f/%.1f", timerQueries ? "GPU" : "GPU~",
+                stageGpu.Min(), stageGpu.Avg(), stageGpu.P99());
+        return line;
+    }
+    std::string GetCounterLine() {
+        return TextFormat("%i DRAWS %i INST %i CULL %i KB %i BUF %i KB ARENA", (int)drawCalls.Avg(), (int)instances.Avg(),
+            (int)culled.Avg(), (int)(uploadBytes.Avg() / 1024.0f), buffersCreated, (int)(arenaHighWater / 1024));
+    }
+
+    // Min/avg/p99 in milliseconds, one line per stage. Returns the y below the overlay
+    int Draw(int posX, int posY, int fontSize) {
+        float frameAvg = frame.Avg();
+        Color frameColor = LIME;
+        if (frameAvg > 1000.0f/15.0f) frameColor = RED;
+        else if (frameAvg > 1000.0f/30.0f) frameColor = ORANGE;
+        DrawText(GetFrameLine().c_str(), posX, posY, fontSize, frameColor);
+        posY += fontSize;
+
+        int lineSize = fontSize / 2;
+        for (int stage = 0; stage < STAGES; stage++) {
+            std::string line = GetStageLine((ProfileStage)stage);
+            if (line.empty()) continue;
+            DrawText(line.c_str(), posX, posY, lineSize, RAYWHITE);
+            posY += lineSize;
+        }
+
+        DrawText(GetCounterLine().c_str(), posX, posY, lineSize, buffersCreated == 0 && !arenaGrew ? LIME : ORANGE);
+        return posY + lineSize;
+    }
+
+    // Same as the overlay, for runs without one
+    void Log() {
+        for (int stage = 0; stage < STAGES; stage++) {
+            std::string line = GetStageLine((ProfileStage)stage);
+            if (!line.empty()) std::cout << "INFO: " << line << "\n";
+        }
+        std::cout << "INFO: " << GetCounterLine() << "\n";
+    }
+};
+
+// Boot to first frame, split into the stages main() marks the end of, plus the time spent on shaders
+// in all of them (see ShaderCache). Starts when the process does
+class BootTimer {
+private:
+    using Clock = std::chrono::steady_clock;
+
+    Clock::time_point start = Clock::now();
+    Clock::time_point last = start;
+    std::vector<std::pair<std::string, float>> stages;  // Milliseconds
+    bool reported = false;
+public:
+    // Ends the stage that started at the previous mark
+    void Mark(const std::string& stage) {
+        Clock::time_point now = Clock::now();
+        stages.push_back(std::make_pair(stage, std::chrono::duration<float, std::milli>(now - last).count()));
+        last = now;
+    }
+
+    // After the first frame was presented
+    void Report() {
+        reported = true;
+
+        float total = std::chrono::duration<float, std::milli>(last - start).count();
+        std::string line = TextFormat("INFO: Boot: %.1f ms to the first frame:", total);
+        for (size_t i = 0; i < stages.size(); i++)
+            line += TextFormat("%s %s %.1f", i == 0 ? "" : ",", stages[i].first.c_str(), stages[i].second);
+        ShaderCacheStats shaders = shaderCache.GetStats();
+        std::cout << line << " ms\n" << TextFormat("INFO: Boot: shaders took %.1f ms of it (%i from the cache, %i compiled, %i not cacheable)\n",
+            shaders.milliseconds, shaders.loaded, shaders.compiled, shaders.unsaved);
+    }
+    bool IsReported() { return reported; }
+};
+
+// Times the enclosing block as one stage
+class ProfileScope {
+private:
+    FrameProfiler& profiler;
+public:
+    ProfileScope(FrameProfiler& profiler, ProfileStage stage, bool gpuWork = false) : profiler(profiler) {
+        profiler.BeginStage(stage, gpuWork);
+    }
+    ~ProfileScope() {
+        profiler.EndStage();
+    }
+};
+
+#endif
@@ -0,0 +1,207 @@
+#ifndef QUILT_H
+#define QUILT_H
+
+#include "raylib.h"
+#include "rlgl.h"
+
+#include <GLES3/gl3.h>
+
+#include <vector>
+#include <algorithm>
+
+#include "raylib_extensions.h"
+
+// Texture unit the layered quilt is bound to for the interleaver (raylib uses 0..n for TEXTURE_2D)
+#define QUILT_LAYER_TEXTURE_UNIT 8
+#define QUILT_DEPTH_TEXTURE_UNIT 9
+
+enum class QuiltLayout : unsigned char {
+    Atlas,      // One big texture, views are tiles carved out with rlViewport
+    Layered     // One 2D texture array layer per view
+};
+
+// Render target for all views of the quilt.
+// The interleaver (Shaders/quilt.shader) must be loaded with GetShaderDefines(layout) to match the layout.
+class Quilt {
+private:
+    QuiltLayout layout;
+
+    // Atlas: the render texture. Layered: framebuffer + array texture (texture.id) + depth renderbuffer (depth.id),
+    // wrapped in a RenderTexture2D so raylib's BeginTextureMode can be used for both
+    RenderTexture2D target = { 0 };
+
+    // Layered only: keep every view's depth in a second array texture (depth.id) so it can be sampled later
+    bool depthLayers;
+public:
+    int tilesX;
+    int tilesY;
+    int tileWidth;
+    int tileHeight;
+
+    Quilt(QuiltLayout layout, std::pair<int, int> tiles, std::pair<int, int> tileRes, bool depthLayers = false)
+        : layout(layout), depthLayers(depthLayers && layout == QuiltLayout::Layered),
+          tilesX(tiles.first), tilesY(tiles.second), tileWidth(tileRes.first), tileHeight(tileRes.second) {
+        if (layout == QuiltLayout::Atlas) {
+            target = LoadRenderTexture(tileWidth * tilesX, tileHeight * tilesY);
+            return;
+        }
+
+        target.texture = Texture2D{ 0, tileWidth, tileHeight, 1, PIXELFORMAT_UNCOMPRESSED_R8G8B8A8 };
+        target.depth = Texture2D{ 0, tileWidth, tileHeight, 1, 0 };
+
+        glGenTextures(1, &target.texture.id);
+        glBindTexture(GL_TEXTURE_2D_ARRAY, target.texture.id);
+        glTexStorage3D(GL_TEXTURE_2D_ARRAY, 1, GL_RGBA8, tileWidth, tileHeight, GetViewCount());
+        glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+        glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+        glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+        glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+        glBindTexture(GL_TEXTURE_2D_ARRAY, 0);
+
+        glGenFramebuffers(1, &target.id);
+        glBindFramebuffer(GL_FRAMEBUFFER, target.id);
+        if (this->depthLayers) {
+            // Depth textures can't be filtered in ES3, they're read with NEAREST
+            glGenTextures(1, &target.depth.id);
+            glBindTexture(GL_TEXTURE_2D_ARRAY, target.depth.id);
+            glTexStorage3D(GL_TEXTURE_2D_ARRAY, 1, GL_DEPTH_COMPONENT24, tileWidth, tileHeight, GetViewCount());
+            glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+            glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+            glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+            glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+            glBindTexture(GL_TEXTURE_2D_ARRAY, 0);
+            glFramebufferTextureLayer(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, target.depth.id, 0, 0);
+        } else {
+            // A single depth buffer is shared by all layers, it's cleared for every view
+            glGenRenderbuffers(1, &target.depth.id);
+            glBindRenderbuffer(GL_RENDERBUFFER, target.depth.id);
+            glRenderbufferStorage(GL_RENDERBUFFER, GL_DEPTH_COMPONENT24, tileWidth, tileHeight);
+            glBindRenderbuffer(GL_RENDERBUFFER, 0);
+            glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, GL_RENDERBUFFER, target.depth.id);
+        }
+        glFramebufferTextureLayer(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, target.texture.id, 0, 0);
+        if (glCheckFramebufferStatus(GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE)
+            std::cout << "WARNING: Layered quilt framebuffer is incomplete\n";
+        glBindFramebuffer(GL_FRAMEBUFFER, 0);
+    }
+    ~Quilt() {
+        if (layout == QuiltLayout::Atlas) {
+            UnloadRenderTexture(target);
+            return;
+        }
+        glDeleteFramebuffers(1, &target.id);
+        if (depthLayers)
+            glDeleteTextures(1, &target.depth.id);
+        else
+            glDeleteRenderbuffers(1, &target.depth.id);
+        glDeleteTextures(1, &target.texture.id);
+    }
+    Quilt(const Quilt&) = delete;
+    Quilt& operator=(const Quilt&) = delete;
+
+    QuiltLayout GetLayout() { return layout; }
+    int GetViewCount() { return tilesX * tilesY; }
+    int GetWidth() { return tileWidth * tilesX; }
+    int GetHeight() { return tileHeight * tilesY; }
+
+    // Tile of view i in the atlas layout
+    Rectangle GetViewRect(int i) {
+        return Rectangle{ (float)((i % tilesX) * tileWidth), (float)((i / tilesX) * tileHeight),
+            (float)tileWidth, (float)tileHeight };
+    }
+
+    static std::string GetShaderDefines(QuiltLayout layout) {
+        return layout == QuiltLayout::Layered ? "#define QUILT_LAYERED\n" : "";
+    }
+
+    // Atlas views share one clear, layered views are cleared one by one in BeginView
+    void Begin(Color clearColor) {
+        BeginTextureMode(target);
+        if (layout == QuiltLayout::Atlas)
+            ClearBackground(clearColor);
+    }
+    void BeginView(int i, Color clearColor) {
+        if (layout == QuiltLayout::Atlas) {
+            Rectangle rect = GetViewRect(i);
+            rlViewport(rect.x, rect.y, rect.width, rect.height);
+            return;
+        }
+        glFramebufferTextureLayer(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, target.texture.id, 0, i);
+        if (depthLayers)
+            glFramebufferTextureLayer(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, target.depth.id, 0, i);
+        rlViewport(0, 0, tileWidth, tileHeight);
+        ClearBackground(clearColor);
+    }
+    void EndView() {
+        if (layout == QuiltLayout::Atlas || depthLayers) return;
+
+        // The depth of a finished view is never read again, let tiled GPUs skip writing it back
+        rlDrawRenderBatchActive();
+        GLenum depthAttachment = GL_DEPTH_ATTACHMENT;
+        glInvalidateFramebuffer(GL_FRAMEBUFFER, 1, &depthAttachment);
+    }
+    void End() {
+        EndTextureMode();
+    }
+
+    // Cover the current view (between BeginView and EndView), e.g. with a full screen shader
+    void FillView() {
+        DrawRectangle(0, 0, target.texture.width, target.texture.height, WHITE);
+    }
+
+    // Read the quilt back as one upright atlas image, whatever the layout (for dumps, not per frame)
+    Image LoadQuiltImage() {
+        if (layout == QuiltLayout::Atlas) {
+            Image image = LoadImageFromTexture(target.texture);
+            ImageFlipVertical(&image);
+            return image;
+        }
+
+        Image image = GenImageColor(GetWidth(), GetHeight(), BLANK);
+        unsigned char* atlas = (unsigned char*)image.data;
+        std::vector<unsigned char> pixels(tileWidth * tileHeight * 4);
+
+        glBindFramebuffer(GL_FRAMEBUFFER, target.id);
+        for (int i = 0; i < GetViewCount(); i++) {
+            glFramebufferTextureLayer(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, target.texture.id, 0, i);
+            glReadPixels(0, 0, tileWidth, tileHeight, GL_RGBA, GL_UNSIGNED_BYTE, pixels.data());
+
+            // GL rows are bottom up, same as the atlas' viewports
+            Rectangle rect = GetViewRect(i);
+            for (int row = 0; row < tileHeight; row++) {
+                int atlasRow = GetHeight() - 1 - ((int)rect.y + row);
+                std::copy(&pixels[row * tileWidth * 4], &pixels[(row + 1) * tileWidth * 4],
+                    &atlas[(atlasRow * GetWidth() + (int)rect.x) * 4]);
+            }
+        }
+        glBindFramebuffer(GL_FRAMEBUFFER, 0);
+        return image;
+    }
+
+    // Bind the quilt for the interleaver, call between BeginShaderMode and EndShaderMode
+    void SetShaderTexture(Shader shader, int loc) {
+        if (layout == QuiltLayout::Atlas) {
+            SetShaderValueTexture(shader, loc, target.texture);
+            return;
+        }
+        glActiveTexture(GL_TEXTURE0 + QUILT_LAYER_TEXTURE_UNIT);
+        glBindTexture(GL_TEXTURE_2D_ARRAY, target.texture.id);
+        glActiveTexture(GL_TEXTURE0);
+
+        int unit = QUILT_LAYER_TEXTURE_UNIT;
+        SetShaderValue(shader, loc, &unit, SHADER_UNIFORM_INT);
+    }
+
+    // Bind the depth layers (see depthLayers), call between BeginShaderMode and EndShaderMode
+    void SetShaderDepthTexture(Shader shader, int loc) {
+        if (!depthLayers) return;
+        glActiveTexture(GL_TEXTURE0 + QUILT_DEPTH_TEXTURE_UNIT);
+        glBindTexture(GL_TEXTURE_2D_ARRAY, target.depth.id);
+        glActiveTexture(GL_TEXTURE0);
+
+        int unit = QUILT_DEPTH_TEXTURE_UNIT;
+        SetShaderValue(shader, loc, &unit, SHADER_UNIFORM_INT);
+    }
+};
+
+#endif
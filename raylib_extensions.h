@@ -7,6 +7,19 @@
 #include <GLES3/gl3.h>
 #include <GLES3/gl3ext.h>
 
+#include <map>
+#include <tuple>
+#include <vector>
+#include <cstddef>
+#include <cstring>
+#include <algorithm>
+
+#include "culling.h"
+#include "simd.h"
+#include "meshformat.h"
+#include "framearena.h"
+#include "shadercache.h"
+
 Vector4 Vector4Transform(Vector4 q, Matrix mat)
 {
     Vector4 result = { 0 };
@@ -23,17 +36,6 @@ float GetRandomFloat(float min, float max) {
     return min + static_cast <float> (rand()) /( static_cast <float> (RAND_MAX/(max-min)));
 }
 
-void DrawFPSSize(int posX, int posY, int fontSize)
-{
-    Color color = LIME; // good fps
-    int fps = GetFPS();
-
-    if (fps < 30 && fps >= 15) color = ORANGE;  // warning FPS
-    else if (fps < 15) color = RED;    // bad FPS
-
-    DrawText(TextFormat("%2i FPS", GetFPS()), posX, posY, fontSize, color);
-}
-
 void DrawCubeAndWires(Vector3 pos, float x, float y, float z, Color c, Shader s) {
     BeginShaderMode(s);
         DrawCube(pos, x, y, z, c);
@@ -78,6 +80,21 @@ Matrix frustumMatrixOffAxis(double left, double right, double bottom, double top
     return matFrustum;
 }
 
+Matrix GetMatrixProjectionLG(Camera3D camera, float aspect, float offset)
+{
+    // NOTE: zNear and zFar values are important when computing depth buffer values
+    double top = RL_CULL_DISTANCE_NEAR*tan(camera.fovy*0.5*DEG2RAD);
+    double right = top*aspect;
+
+    return frustumMatrixOffAxis(-right, right, -top, top, RL_CULL_DISTANCE_NEAR, RL_CULL_DISTANCE_FAR, offset, aspect, camera.fovy, camera.position.z);
+}
+
+Matrix GetMatrixViewProjectionLG(Camera3D camera, float aspect, float offset)
+{
+    Matrix matView = MatrixLookAt(camera.position, camera.target, camera.up);
+    return MatrixMultiply(matView, GetMatrixProjectionLG(camera, aspect, offset));
+}
+
 void BeginMode3DLG(Camera3D camera, float aspect, float offset)
 {
     //rlDrawRenderBatchActive();      // Update and draw internal render batch
@@ -86,15 +103,8 @@ void BeginMode3DLG(Camera3D camera, float aspect, float offset)
     rlPushMatrix();                 // Save previous matrix, which contains the settings for the 2d ortho projection
     rlLoadIdentity();               // Reset current matrix (projection)
 
-    // NOTE: zNear and zFar values are important when computing depth buffer values
-    if (camera.projection == CAMERA_PERSPECTIVE)
-    {
-        // Setup perspective projection
-        double top = RL_CULL_DISTANCE_NEAR*tan(camera.fovy*0.5*DEG2RAD);
-        double right = top*aspect;
-
-        rlSetMatrixProjection(frustumMatrixOffAxis(-right, right, -top, top, RL_CULL_DISTANCE_NEAR, RL_CULL_DISTANCE_FAR, offset, aspect, camera.fovy, camera.position.z));
-    }
+    // Setup perspective projection
+    if (camera.projection == CAMERA_PERSPECTIVE) rlSetMatrixProjection(GetMatrixProjectionLG(camera, aspect, offset));
 
     rlMatrixMode(RL_MODELVIEW);     // Switch back to modelview matrix
     rlLoadIdentity();               // Reset current matrix (modelview)
@@ -110,176 +120,602 @@ typedef struct float4 {
     float v[4];
 } float4;
 
-void DrawMeshInstancedC(Mesh mesh, Material material, Matrix *transforms, Vector4 *colors, int instances)
+// MULTIVIEW ----------
+// Single pass quilt rendering: each instanced draw is submitted once and fanned out to every
+// view on the GPU. Instances are repeated viewCount times (attribute divisor = viewCount) and
+// the shader recovers the view from gl_InstanceID, see Shaders/multiview.glsl
+#define MULTIVIEW_MAX_VIEWS 64
+#define MULTIVIEW_BINDING 0
+
+// Matches the std140 layout of the Multiview uniform block
+typedef struct MultiviewBlock {
+    float16 viewProjection[MULTIVIEW_MAX_VIEWS];
+    float4 viewRect[MULTIVIEW_MAX_VIEWS];  // Tile x, y, width, height in quilt pixels
+    float4 quiltInfo;                       // Quilt width, height, view count
+} MultiviewBlock;
+
+struct Multiview {
+    bool enabled = false;
+    int viewCount = 1;
+    unsigned int ubo = 0;
+};
+Multiview multiview;
+
+void InitMultiview()
 {
-    // Check instancing
-    if (instances <= 1) return;
+    multiview.enabled = true;
 
-    int MAX_MATERIAL_MAPS = 12;
+    glGenBuffers(1, &multiview.ubo);
+    glBindBuffer(GL_UNIFORM_BUFFER, multiview.ubo);
+    glBufferData(GL_UNIFORM_BUFFER, sizeof(MultiviewBlock), NULL, GL_DYNAMIC_DRAW);
+    glBindBufferBase(GL_UNIFORM_BUFFER, MULTIVIEW_BINDING, multiview.ubo);
+    glBindBuffer(GL_UNIFORM_BUFFER, 0);
+}
 
-    float16 *instanceTransforms = NULL;
-    float4 *instanceColors = NULL;
-    unsigned int instanceTransformsVboId = 0;
-    unsigned int instanceColorsVboId = 0;
+void UpdateMultiview(Matrix *viewProjections, Rectangle *viewRects, int viewCount, int quiltWidth, int quiltHeight)
+{
+    if (viewCount > MULTIVIEW_MAX_VIEWS)
+    {
+        std::cout << "WARNING: Multiview supports at most " << MULTIVIEW_MAX_VIEWS << " views, got " << viewCount << "\n";
+        viewCount = MULTIVIEW_MAX_VIEWS;
+    }
+    multiview.viewCount = viewCount;
 
-    // Bind shader program
-    rlEnableShader(material.shader.id);
+    MultiviewBlock block = { 0 };
+    for (int i = 0; i < viewCount; i++)
+    {
+        block.viewProjection[i] = MatrixToFloatV(viewProjections[i]);
+        block.viewRect[i] = float4{ { viewRects[i].x, viewRects[i].y, viewRects[i].width, viewRects[i].height } };
+    }
+    block.quiltInfo = float4{ { (float)quiltWidth, (float)quiltHeight, (float)viewCount, 0.0f } };
 
-    // Send required data to shader (matrices, values)
-    //-----------------------------------------------------
-    // Get a copy of current matrices to work with,
-    // just in case stereo render is required and we need to modify them
-    // NOTE: At this point the modelview matrix just contains the view matrix (camera)
-    // That's because BeginMode3D() sets it and there is no model-drawing function
-    // that modifies it, all use rlPushMatrix() and rlPopMatrix()
-    Matrix matModel = MatrixIdentity();
-    Matrix matView = rlGetMatrixModelview();
-    Matrix matModelView = MatrixIdentity();
-    Matrix matProjection = rlGetMatrixProjection();
+    glBindBuffer(GL_UNIFORM_BUFFER, multiview.ubo);
+    glBufferSubData(GL_UNIFORM_BUFFER, 0, sizeof(MultiviewBlock), &block);
+    glBindBuffer(GL_UNIFORM_BUFFER, 0);
+}
 
-    // Upload view and projection matrices (if locations available)
-    if (material.shader.locs[SHADER_LOC_MATRIX_VIEW] != -1) rlSetUniformMatrix(material.shader.locs[SHADER_LOC_MATRIX_VIEW], matView);
-    if (material.shader.locs[SHADER_LOC_MATRIX_PROJECTION] != -1) rlSetUniformMatrix(material.shader.locs[SHADER_LOC_MATRIX_PROJECTION], matProjection);
+void UnloadMultiview()
+{
+    if (multiview.ubo != 0) glDeleteBuffers(1, &multiview.ubo);
+    multiview = Multiview();
+}
 
-    // Create instances buffer
-    instanceTransforms = (float16 *)RL_MALLOC(instances*sizeof(float16));
-    instanceColors = (float4 *)RL_MALLOC(instances*sizeof(float4));
-    
-    // Fill buffer with instances transformations as float16 arrays
-    for (int i = 0; i < instances; i++) instanceTransforms[i] = MatrixToFloatV(transforms[i]);
-    for (int i = 0; i < instances; i++) {
-        float4 c = { 0 };
-        c.v[0] = colors[i].x;
-        c.v[1] = colors[i].y;
-        c.v[2] = colors[i].z;
-        c.v[3] = colors[i].w;
-        instanceColors[i] = c;
-    }
-    
-    // Enable mesh VAO to attach new buffer
-    rlEnableVertexArray(mesh.vaoId);
-    
-    // This could alternatively use a static VBO and either glMapBuffer() or glBufferSubData().
-    // It isn't clear which would be reliably faster in all cases and on all platforms,
-    // anecdotally glMapBuffer() seems very slow (syncs) while glBufferSubData() seems
-    // no faster, since we're transferring all the transform matrices anyway
-    instanceTransformsVboId = rlLoadVertexBuffer(instanceTransforms, instances*sizeof(float16), false);
-    
-    // Instances transformation matrices are send to shader attribute location: SHADER_LOC_MATRIX_MODEL
-    for (unsigned int i = 0; i < 4; i++)
+// INSTANCE LAYOUTS ----------
+// How one instance of an instanced draw is laid out in its instance buffer. Attributes are interleaved
+// and bound by name, so shaders don't need their instance attribute locations set up.
+struct InstanceAttribute {
+    const char* name;
+    int components;     // Per location, 1-4
+    int type;           // RL_FLOAT, RL_UNSIGNED_BYTE, ...
+    bool normalized;
+    int offset;         // Bytes into the instance
+    int locations;      // Consecutive locations, 4 for a mat4 (one column each)
+};
+
+struct InstanceLayout {
+    int stride;
+    std::vector<InstanceAttribute> attributes;
+    // World space bounds of an instance from its mesh's, for culling (see DrawList::Cull)
+    BoundingSphere (*bounds)(const unsigned char* instance, BoundingSphere meshBounds);
+};
+
+int GetAttributeTypeSize(int type)
+{
+    switch (type)
     {
-        rlEnableVertexAttribute(material.shader.locs[SHADER_LOC_MATRIX_MODEL] + i);
-        rlSetVertexAttribute(material.shader.locs[SHADER_LOC_MATRIX_MODEL] + i, 4, RL_FLOAT, 0, sizeof(Matrix), (void *)(i*sizeof(Vector4)));
-        rlSetVertexAttributeDivisor(material.shader.locs[SHADER_LOC_MATRIX_MODEL] + i, 1);
+        case GL_BYTE: return 1;
+        case RL_UNSIGNED_BYTE: return 1;
+        case GL_HALF_FLOAT: return 2;
+        default: return 4;
     }
+}
 
-    // Create color VBO
-    instanceColorsVboId = rlLoadVertexBuffer(instanceColors, instances*sizeof(float4), false);
+// Half precision float, as read by GL_HALF_FLOAT attributes
+typedef struct Half {
+    unsigned short bits;
+} Half;
 
-    rlEnableVertexAttribute(material.shader.locs[SHADER_LOC_COLOR_DIFFUSE]);
-    rlSetVertexAttribute(material.shader.locs[SHADER_LOC_COLOR_DIFFUSE], 4, RL_FLOAT, 0, sizeof(float4), 0);
-    rlSetVertexAttributeDivisor(material.shader.locs[SHADER_LOC_COLOR_DIFFUSE], 1);
-    
-    // Disable VAO and VBOs
-    rlDisableVertexBuffer();
-    rlDisableVertexArray();
-    
-    // Accumulate internal matrix transform (push/pop) and view matrix
-    // NOTE: In this case, model instance transformation must be computed in the shader
-    matModelView = MatrixMultiply(rlGetMatrixTransform(), matView);
+// Rounds to nearest, flushes what's too small for a normal half to zero and clamps the rest to infinity
+Half ToHalf(float value)
+{
+    unsigned int bits;
+    memcpy(&bits, &value, sizeof(bits));
+    unsigned int sign = (bits >> 16) & 0x8000;
+    int exponent = (int)((bits >> 23) & 0xFF) - 127 + 15;
+    unsigned int mantissa = bits & 0x7FFFFF;
+
+    if (exponent <= 0) return Half{ (unsigned short)sign };
+    if (exponent >= 31) return Half{ (unsigned short)(sign | 0x7C00) };
+    // A carry out of the mantissa correctly bumps the exponent
+    unsigned int half = sign | (exponent << 10) | (mantissa >> 13);
+    if (mantissa & 0x1000) half++;
+    return Half{ (unsigned short)half };
+}
 
-    // Upload model normal matrix (if locations available)
-    if (material.shader.locs[SHADER_LOC_MATRIX_NORMAL] != -1) rlSetUniformMatrix(material.shader.locs[SHADER_LOC_MATRIX_NORMAL], MatrixTranspose(MatrixInvert(matModel)));
-    //-----------------------------------------------------
+float FromHalf(Half half)
+{
+    unsigned int sign = (unsigned int)(half.bits & 0x8000) << 16;
+    unsigned int exponent = (half.bits >> 10) & 0x1F;
+    unsigned int mantissa = half.bits & 0x3FF;
+
+    unsigned int bits;
+    if (exponent == 0) bits = sign;
+    else if (exponent == 31) bits = sign | 0x7F800000 | (mantissa << 13);
+    else bits = sign | ((exponent - 15 + 127) << 23) | (mantissa << 13);
+    float value;
+    memcpy(&value, &bits, sizeof(value));
+    return value;
+}
 
-    // Bind active texture maps (if available)
-    for (int i = 0; i < MAX_MATERIAL_MAPS; i++)
+// Unit quaternion with signed normalized 8 bit components (about half a degree of precision)
+typedef struct PackedQuaternion {
+    signed char x, y, z, w;
+} PackedQuaternion;
+
+PackedQuaternion ToPackedQuaternion(Quaternion q)
+{
+    q = QuaternionNormalize(q);
+    return PackedQuaternion{ (signed char)roundf(q.x*127.0f), (signed char)roundf(q.y*127.0f),
+        (signed char)roundf(q.z*127.0f), (signed char)roundf(q.w*127.0f) };
+}
+
+Quaternion FromPackedQuaternion(PackedQuaternion q)
+{
+    return QuaternionNormalize(Quaternion{ q.x/127.0f, q.y/127.0f, q.z/127.0f, q.w/127.0f });
+}
+
+// Attribute format of every type an instance struct member can have, see InstanceAttributeOf
+template <typename T> struct InstanceAttributeFormat;
+template <> struct InstanceAttributeFormat<float> { enum { components = 1, type = RL_FLOAT, normalized = false, locations = 1 }; };
+template <> struct InstanceAttributeFormat<Vector2> { enum { components = 2, type = RL_FLOAT, normalized = false, locations = 1 }; };
+template <> struct InstanceAttributeFormat<Vector3> { enum { components = 3, type = RL_FLOAT, normalized = false, locations = 1 }; };
+template <> struct InstanceAttributeFormat<Vector4> { enum { components = 4, type = RL_FLOAT, normalized = false, locations = 1 }; };
+template <> struct InstanceAttributeFormat<float16> { enum { components = 4, type = RL_FLOAT, normalized = false, locations = 4 }; };
+template <> struct InstanceAttributeFormat<Half> { enum { components = 1, type = GL_HALF_FLOAT, normalized = false, locations = 1 }; };
+template <> struct InstanceAttributeFormat<Color> { enum { components = 4, type = RL_UNSIGNED_BYTE, normalized = true, locations = 1 }; };
+template <> struct InstanceAttributeFormat<PackedQuaternion> { enum { components = 4, type = GL_BYTE, normalized = true, locations = 1 }; };
+// Arrays of scalars, e.g. Half[3] for a vec3
+template <typename T, int N> struct InstanceAttributeFormat<T[N]> {
+    static_assert(InstanceAttributeFormat<T>::components*N <= 4 && InstanceAttributeFormat<T>::locations == 1, "Instance attributes have at most 4 components");
+    enum { components = InstanceAttributeFormat<T>::components*N, type = InstanceAttributeFormat<T>::type,
+        normalized = InstanceAttributeFormat<T>::normalized, locations = 1 };
+};
+
+// The shader attribute name for a member of an instance struct, e.g. InstanceAttributeOf("lineStart", &LineInstance::start)
+template <typename Instance, typename T>
+InstanceAttribute InstanceAttributeOf(const char* name, T Instance::*member)
+{
+    typedef InstanceAttributeFormat<T> Format;
+    static const Instance instance = Instance();
+    int offset = (int)((const char*)&(instance.*member) - (const char*)&instance);
+    return InstanceAttribute{ name, Format::components, Format::type, (bool)Format::normalized, offset, Format::locations };
+}
+
+template <typename Instance, BoundingSphere (*Bounds)(const Instance&, BoundingSphere)>
+BoundingSphere GetInstanceBounds(const unsigned char* instance, BoundingSphere meshBounds)
+{
+    return Bounds(*(const Instance*)instance, meshBounds);
+}
+// A layout from an instance struct, its attributes and how to bound it for culling
+template <typename Instance, BoundingSphere (*Bounds)(const Instance&, BoundingSphere)>
+InstanceLayout MakeInstanceLayout(std::vector<InstanceAttribute> attributes)
+{
+    return InstanceLayout{ sizeof(Instance), attributes, GetInstanceBounds<Instance, Bounds> };
+}
+
+// Full transform and color per instance, what DrawList::DrawMeshInstanced submits
+typedef struct ModelInstance {
+    float16 transform;  // Column major, as the shader's mat4
+    Vector4 color;
+} ModelInstance;
+
+BoundingSphere GetModelInstanceBounds(const ModelInstance& instance, BoundingSphere meshBounds)
+{
+    const float* m = instance.transform.v;
+    Matrix transform = { m[0], m[4], m[8], m[12], m[1], m[5], m[9], m[13], m[2], m[6], m[10], m[14], m[3], m[7], m[11], m[15] };
+    return TransformBoundingSphere(meshBounds, transform);
+}
+
+const InstanceLayout MODEL_INSTANCE_LAYOUT = MakeInstanceLayout<ModelInstance, GetModelInstanceBounds>({
+    InstanceAttributeOf("matModel", &ModelInstance::transform),
+    InstanceAttributeOf("colDiffuse", &ModelInstance::color),
+});
+
+// Translation, rotation and scale (no shear or mirroring) and an 8 bit color, 28 bytes instead of
+// ModelInstance's 80. Read by shaders compiled with COMPACT_INSTANCE (see Shaders/lit_instanced.shader)
+typedef struct CompactInstance {
+    Vector3 position;
+    Half scale[3];
+    unsigned short padding;     // Keeps the rotation and the next instance's position 4 byte aligned
+    PackedQuaternion rotation;
+    Color color;
+} CompactInstance;
+
+CompactInstance ToCompactInstance(Matrix transform, Color color)
+{
+    // Scale is the length of each basis vector, the rotation what's left once they're normalized
+    Vector3 scale = {
+        Vector3Length(Vector3{ transform.m0, transform.m1, transform.m2 }),
+        Vector3Length(Vector3{ transform.m4, transform.m5, transform.m6 }),
+        Vector3Length(Vector3{ transform.m8, transform.m9, transform.m10 })
+    };
+    float sx = scale.x > 0.0f ? 1.0f/scale.x : 0.0f;
+    float sy = scale.y > 0.0f ? 1.0f/scale.y : 0.0f;
+    float sz = scale.z > 0.0f ? 1.0f/scale.z : 0.0f;
+    // Row major rotation, rows of raylib matrices are m0 m4 m8 etc.
+    float r[3][3] = {
+        { transform.m0*sx, transform.m4*sy, transform.m8*sz },
+        { transform.m1*sx, transform.m5*sy, transform.m9*sz },
+        { transform.m2*sx, transform.m6*sy, transform.m10*sz },
+    };
+
+    Quaternion q;
+    float trace = r[0][0] + r[1][1] + r[2][2];
+    if (trace > 0.0f) {
+        float t = sqrtf(trace + 1.0f)*2.0f;
+        q = Quaternion{ (r[2][1] - r[1][2])/t, (r[0][2] - r[2][0])/t, (r[1][0] - r[0][1])/t, 0.25f*t };
+    } else if (r[0][0] > r[1][1] && r[0][0] > r[2][2]) {
+        float t = sqrtf(1.0f + r[0][0] - r[1][1] - r[2][2])*2.0f;
+        q = Quaternion{ 0.25f*t, (r[0][1] + r[1][0])/t, (r[0][2] + r[2][0])/t, (r[2][1] - r[1][2])/t };
+    } else if (r[1][1] > r[2][2]) {
+        float t = sqrtf(1.0f + r[1][1] - r[0][0] - r[2][2])*2.0f;
+        q = Quaternion{ (r[0][1] + r[1][0])/t, 0.25f*t, (r[1][2] + r[2][1])/t, (r[0][2] - r[2][0])/t };
+    } else {
+        float t = sqrtf(1.0f + r[2][2] - r[0][0] - r[1][1])*2.0f;
+        q = Quaternion{ (r[0][2] + r[2][0])/t, (r[1][2] + r[2][1])/t, 0.25f*t, (r[1][0] - r[0][1])/t };
+    }
+
+    return CompactInstance{ Vector3{ transform.m12, transform.m13, transform.m14 },
+        { ToHalf(scale.x), ToHalf(scale.y), ToHalf(scale.z) }, 0, ToPackedQuaternion(q), color };
+}
+
+BoundingSphere GetCompactInstanceBounds(const CompactInstance& instance, BoundingSphere meshBounds)
+{
+    Vector3 scale = { FromHalf(instance.scale[0]), FromHalf(instance.scale[1]), FromHalf(instance.scale[2]) };
+    Vector3 center = Vector3RotateByQuaternion(Vector3Multiply(meshBounds.center, scale), FromPackedQuaternion(instance.rotation));
+    return BoundingSphere{ Vector3Add(instance.position, center), meshBounds.radius*std::max(scale.x, std::max(scale.y, scale.z)) };
+}
+
+const InstanceLayout COMPACT_INSTANCE_LAYOUT = MakeInstanceLayout<CompactInstance, GetCompactInstanceBounds>({
+    InstanceAttributeOf("instancePosition", &CompactInstance::position),
+    InstanceAttributeOf("instanceScale", &CompactInstance::scale),
+    InstanceAttributeOf("instanceRotation", &CompactInstance::rotation),
+    InstanceAttributeOf("instanceColor", &CompactInstance::color),
+});
+
+// A line segment, expanded to a quad facing each view on the GPU (see Shaders/line_instanced.shader).
+// Drawn with a GenMeshPlaneY(1, 1, 1, 1) quad
+typedef struct LineInstance {
+    Vector3 start;      // World space
+    Vector3 end;
+    float width;        // Clip space
+    Color color;
+} LineInstance;
+
+BoundingSphere GetLineInstanceBounds(const LineInstance& line, BoundingSphere meshBounds)
+{
+    // The width is in clip space, in world units it's smaller for anything but tiny w
+    return BoundingSphere{ Vector3Lerp(line.start, line.end, 0.5f), Vector3Distance(line.start, line.end)*0.5f + line.width };
+}
+
+const InstanceLayout LINE_INSTANCE_LAYOUT = MakeInstanceLayout<LineInstance, GetLineInstanceBounds>({
+    InstanceAttributeOf("lineStart", &LineInstance::start),
+    InstanceAttributeOf("lineEnd", &LineInstance::end),
+    InstanceAttributeOf("lineWidth", &LineInstance::width),
+    InstanceAttributeOf("lineColor", &LineInstance::color),
+});
+
+// Pairs of endpoints, the 12 edges of a cube from -1 to 1
+const Vector3 CUBE_EDGE_LINES[24] = {
+    { 1, 1, 1 }, { -1, 1, 1 },    { 1, -1, 1 }, { -1, -1, 1 },    { 1, 1, -1 }, { -1, 1, -1 },    { 1, -1, -1 }, { -1, -1, -1 },
+    { 1, 1, 1 }, { 1, 1, -1 },    { 1, -1, 1 }, { 1, -1, -1 },    { -1, 1, 1 }, { -1, 1, -1 },    { -1, -1, 1 }, { -1, -1, -1 },
+    { 1, 1, 1 }, { 1, -1, 1 },    { 1, 1, -1 }, { 1, -1, -1 },    { -1, 1, 1 }, { -1, -1, 1 },    { -1, 1, -1 }, { -1, -1, -1 },
+};
+
+// Lines between each pair of endpoints (count is the number of endpoints), transformed to world space
+// a batch at a time (see simd.h) instead of one Vector3Transform per endpoint
+void AppendLineInstances(Matrix transform, const Vector3 *endpoints, int count, float width, Color color,
+        InstanceBatch<LineInstance>& lines)
+{
+    Vector3 world[64];
+    LineInstance *line = lines.Append(count/2);
+    for (int first = 0; first < count; first += 64) {
+        int batch = std::min(count - first, 64);
+        TransformPoints(endpoints + first, batch, transform, world);
+        for (int i = 0; i + 1 < batch; i += 2)
+            *line++ = LineInstance{ world[i], world[i + 1], width, color };
+    }
+}
+
+// PACKED MESHES ----------
+// Meshes from LoadPackedMesh (see packedmesh.h) keep interleaved PackedVertex data in vboId[0], their indices
+// in vboId[6] and nothing on the CPU. Instanced draws bind and draw them by what's registered here.
+
+struct PackedMeshFormat {
+    unsigned int indexType;     // GL_UNSIGNED_SHORT or GL_UNSIGNED_INT
+    float radius;               // Bounding sphere around the origin
+};
+std::map<unsigned int, PackedMeshFormat> packedMeshes;  // By vboId[0]
+
+// NULL for meshes with raylib's layout
+const PackedMeshFormat *GetPackedMeshFormat(Mesh mesh)
+{
+    if (mesh.vboId == NULL) return NULL;
+    auto it = packedMeshes.find(mesh.vboId[0]);
+    return it != packedMeshes.end() ? &it->second : NULL;
+}
+
+void SetPackedMeshAttributes(Mesh mesh, Shader shader)
+{
+    rlEnableVertexBuffer(mesh.vboId[0]);
+    rlSetVertexAttribute(shader.locs[SHADER_LOC_VERTEX_POSITION], 3, GL_SHORT, 1, sizeof(PackedVertex),
+        (void *)offsetof(PackedVertex, position));
+    rlEnableVertexAttribute(shader.locs[SHADER_LOC_VERTEX_POSITION]);
+    if (shader.locs[SHADER_LOC_VERTEX_TEXCOORD01] != -1)
     {
-        if (material.maps[i].texture.id > 0)
-        {
-            // Select current shader texture slot
-            rlActiveTextureSlot(i);
+        rlSetVertexAttribute(shader.locs[SHADER_LOC_VERTEX_TEXCOORD01], 2, GL_UNSIGNED_SHORT, 1, sizeof(PackedVertex),
+            (void *)offsetof(PackedVertex, texcoord));
+        rlEnableVertexAttribute(shader.locs[SHADER_LOC_VERTEX_TEXCOORD01]);
+    }
+    if (shader.locs[SHADER_LOC_VERTEX_NORMAL] != -1)
+    {
+        rlSetVertexAttribute(shader.locs[SHADER_LOC_VERTEX_NORMAL], 3, GL_BYTE, 1, sizeof(PackedVertex),
+            (void *)offsetof(PackedVertex, normal));
+        rlEnableVertexAttribute(shader.locs[SHADER_LOC_VERTEX_NORMAL]);
+    }
+    if (shader.locs[SHADER_LOC_VERTEX_COLOR] != -1)
+    {
+        float value[4] = { 1.0f, 1.0f, 1.0f, 1.0f };
+        rlSetVertexAttributeDefault(shader.locs[SHADER_LOC_VERTEX_COLOR], value, SHADER_ATTRIB_VEC4, 4);
+        rlDisableVertexAttribute(shader.locs[SHADER_LOC_VERTEX_COLOR]);
+    }
+    rlEnableVertexBufferElement(mesh.vboId[6]);
+}
 
-            // Enable texture for active slot
-            if ((i == MATERIAL_MAP_IRRADIANCE) ||
-                (i == MATERIAL_MAP_PREFILTER) ||
-                (i == MATERIAL_MAP_CUBEMAP)) rlEnableTextureCubemap(material.maps[i].texture.id);
-            else rlEnableTexture(material.maps[i].texture.id);
+// INSTANCE STREAMS ----------
+// Persistent instance buffers for instanced draws. A stream's buffer is orphaned on every upload and only
+// reallocated when the instance count grows past the high-water mark. Every shader drawing the stream
+// gets a VAO that binds the mesh attributes and the layout's instance attributes once.
+
+// A stream's vertex array for one shader, attribute locations differ between programs
+struct InstanceBinding {
+    unsigned int vaoId = 0;
+    std::vector<int> locations; // First location of each layout attribute, -1 if the shader doesn't use it
+    int divisor = 1;        // Instance attribute divisor the VAO is configured with
+    int first = 0;          // Instance the VAO's instance attributes start at
+};
+
+struct InstanceStream {
+    unsigned int vboId = 0;
+    const InstanceLayout* layout = NULL;
+    int capacity = 0;       // In instances
+    std::map<unsigned int, InstanceBinding> bindings;   // By shader, e.g. a draw and its shadow pass
+};
+
+// Per frame counters, see ResetInstanceStats()
+struct InstanceStats {
+    int buffersCreated = 0;     // Buffer objects created or reallocated
+    long bytesUploaded = 0;
+    int drawCalls = 0;
+    int instances = 0;
+    int instancesCulled = 0;    // Outside every view, never uploaded (see DrawList::Cull)
+    long arenaBytes = 0;        // Scratch memory the last built frame used (see DrawList::GetArena)
+    int arenaBlocksAllocated = 0;   // By the frame arena so far, unchanged in steady state
+};
+InstanceStats instanceStats;
+
+// Streams are keyed by mesh, shader and a slot, so a mesh+material pair drawn several
+// times per frame (see DrawList::Upload) keeps one stream per draw
+std::map<std::tuple<unsigned int, unsigned int, int>, InstanceStream> instanceStreams;
+std::vector<ModelInstance> instanceStaging;
+
+void ResetInstanceStats()
+{
+    instanceStats = InstanceStats();
+}
 
-            rlSetUniform(material.shader.locs[SHADER_LOC_MAP_ALBEDO + i], &i, SHADER_UNIFORM_INT, 1);
+// Point the instance attributes at the stream's buffer, starting at instance first.
+// GLES has no base instance, drawing a range that doesn't start at the first instance re-points them
+void SetInstanceBindingFirst(InstanceStream *stream, InstanceBinding *binding, int first)
+{
+    binding->first = first;
+
+    glBindBuffer(GL_ARRAY_BUFFER, stream->vboId);
+    for (size_t i = 0; i < stream->layout->attributes.size(); i++)
+    {
+        const InstanceAttribute& attribute = stream->layout->attributes[i];
+        if (binding->locations[i] == -1) continue;
+
+        int locationSize = attribute.components*GetAttributeTypeSize(attribute.type);
+        for (int j = 0; j < attribute.locations; j++)
+        {
+            rlSetVertexAttribute(binding->locations[i] + j, attribute.components, attribute.type, attribute.normalized,
+                stream->layout->stride, (void *)(size_t)(first*stream->layout->stride + attribute.offset + j*locationSize));
         }
     }
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+}
 
-    // Try binding vertex array objects (VAO)
-    // or use VBOs if not possible
-    //rlEnableVertexArray(mesh.vaoId);
-    if (!rlEnableVertexArray(mesh.vaoId))
+void SetInstanceBindingDivisor(InstanceStream *stream, InstanceBinding *binding, int divisor)
+{
+    binding->divisor = divisor;
+
+    for (size_t i = 0; i < stream->layout->attributes.size(); i++)
     {
-        // Bind mesh VBO data: vertex position (shader-location = 0)
+        if (binding->locations[i] == -1) continue;
+        for (int j = 0; j < stream->layout->attributes[i].locations; j++) rlSetVertexAttributeDivisor(binding->locations[i] + j, divisor);
+    }
+}
+
+InstanceStream *GetInstanceStream(Mesh mesh, Material material, const InstanceLayout& layout, int slot)
+{
+    InstanceStream& stream = instanceStreams[std::make_tuple(mesh.vboId[0], material.shader.id, slot)];
+    if (stream.vboId != 0) return &stream;
+
+    stream.layout = &layout;
+    stream.vboId = rlLoadVertexBuffer(NULL, 0, true);
+
+    instanceStats.buffersCreated++;
+    return &stream;
+}
+
+// Created the first time the stream is drawn with a shader
+InstanceBinding *GetInstanceBinding(Mesh mesh, Shader shader, InstanceStream *stream)
+{
+    InstanceBinding& binding = stream->bindings[shader.id];
+    if (binding.vaoId != 0) return &binding;
+
+    binding.vaoId = rlLoadVertexArray();
+    rlEnableVertexArray(binding.vaoId);
+
+    if (GetPackedMeshFormat(mesh) != NULL) SetPackedMeshAttributes(mesh, shader);
+    else
+    {
+        // Bind mesh VBO data: vertex position and texcoords
         rlEnableVertexBuffer(mesh.vboId[0]);
-        rlSetVertexAttribute(material.shader.locs[SHADER_LOC_VERTEX_POSITION], 3, RL_FLOAT, 0, 0, 0);
-        rlEnableVertexAttribute(material.shader.locs[SHADER_LOC_VERTEX_POSITION]);
+        rlSetVertexAttribute(shader.locs[SHADER_LOC_VERTEX_POSITION], 3, RL_FLOAT, 0, 0, 0);
+        rlEnableVertexAttribute(shader.locs[SHADER_LOC_VERTEX_POSITION]);
 
-        // Bind mesh VBO data: vertex texcoords (shader-location = 1)
         rlEnableVertexBuffer(mesh.vboId[1]);
-        rlSetVertexAttribute(material.shader.locs[SHADER_LOC_VERTEX_TEXCOORD01], 2, RL_FLOAT, 0, 0, 0);
-        rlEnableVertexAttribute(material.shader.locs[SHADER_LOC_VERTEX_TEXCOORD01]);
+        rlSetVertexAttribute(shader.locs[SHADER_LOC_VERTEX_TEXCOORD01], 2, RL_FLOAT, 0, 0, 0);
+        rlEnableVertexAttribute(shader.locs[SHADER_LOC_VERTEX_TEXCOORD01]);
 
-        if (material.shader.locs[SHADER_LOC_VERTEX_NORMAL] != -1)
+        // Bind mesh VBO data: normals, colors, tangents and texcoords2 (if available)
+        if (shader.locs[SHADER_LOC_VERTEX_NORMAL] != -1 && mesh.vboId[2] != 0)
         {
-            // Bind mesh VBO data: vertex normals (shader-location = 2)
             rlEnableVertexBuffer(mesh.vboId[2]);
-            rlSetVertexAttribute(material.shader.locs[SHADER_LOC_VERTEX_NORMAL], 3, RL_FLOAT, 0, 0, 0);
-            rlEnableVertexAttribute(material.shader.locs[SHADER_LOC_VERTEX_NORMAL]);
+            rlSetVertexAttribute(shader.locs[SHADER_LOC_VERTEX_NORMAL], 3, RL_FLOAT, 0, 0, 0);
+            rlEnableVertexAttribute(shader.locs[SHADER_LOC_VERTEX_NORMAL]);
         }
-
-        // Bind mesh VBO data: vertex colors (shader-location = 3, if available)
-        if (material.shader.locs[SHADER_LOC_VERTEX_COLOR] != -1)
+        if (shader.locs[SHADER_LOC_VERTEX_COLOR] != -1)
         {
             if (mesh.vboId[3] != 0)
             {
                 rlEnableVertexBuffer(mesh.vboId[3]);
-                rlSetVertexAttribute(material.shader.locs[SHADER_LOC_VERTEX_COLOR], 4, RL_UNSIGNED_BYTE, 1, 0, 0);
-                rlEnableVertexAttribute(material.shader.locs[SHADER_LOC_VERTEX_COLOR]);
+                rlSetVertexAttribute(shader.locs[SHADER_LOC_VERTEX_COLOR], 4, RL_UNSIGNED_BYTE, 1, 0, 0);
+                rlEnableVertexAttribute(shader.locs[SHADER_LOC_VERTEX_COLOR]);
             }
             else
             {
                 // Set default value for unused attribute
-                // NOTE: Required when using default shader and no VAO support
                 float value[4] = { 1.0f, 1.0f, 1.0f, 1.0f };
-                rlSetVertexAttributeDefault(material.shader.locs[SHADER_LOC_VERTEX_COLOR], value, SHADER_ATTRIB_VEC2, 4);
-                rlDisableVertexAttribute(material.shader.locs[SHADER_LOC_VERTEX_COLOR]);
+                rlSetVertexAttributeDefault(shader.locs[SHADER_LOC_VERTEX_COLOR], value, SHADER_ATTRIB_VEC4, 4);
+                rlDisableVertexAttribute(shader.locs[SHADER_LOC_VERTEX_COLOR]);
             }
         }
-
-        // Bind mesh VBO data: vertex tangents (shader-location = 4, if available)
-        if (material.shader.locs[SHADER_LOC_VERTEX_TANGENT] != -1)
+        if (shader.locs[SHADER_LOC_VERTEX_TANGENT] != -1 && mesh.vboId[4] != 0)
         {
             rlEnableVertexBuffer(mesh.vboId[4]);
-            rlSetVertexAttribute(material.shader.locs[SHADER_LOC_VERTEX_TANGENT], 4, RL_FLOAT, 0, 0, 0);
-            rlEnableVertexAttribute(material.shader.locs[SHADER_LOC_VERTEX_TANGENT]);
+            rlSetVertexAttribute(shader.locs[SHADER_LOC_VERTEX_TANGENT], 4, RL_FLOAT, 0, 0, 0);
+            rlEnableVertexAttribute(shader.locs[SHADER_LOC_VERTEX_TANGENT]);
         }
-
-        // Bind mesh VBO data: vertex texcoords2 (shader-location = 5, if available)
-        if (material.shader.locs[SHADER_LOC_VERTEX_TEXCOORD02] != -1)
+        if (shader.locs[SHADER_LOC_VERTEX_TEXCOORD02] != -1 && mesh.vboId[5] != 0)
         {
             rlEnableVertexBuffer(mesh.vboId[5]);
-            rlSetVertexAttribute(material.shader.locs[SHADER_LOC_VERTEX_TEXCOORD02], 2, RL_FLOAT, 0, 0, 0);
-            rlEnableVertexAttribute(material.shader.locs[SHADER_LOC_VERTEX_TEXCOORD02]);
+            rlSetVertexAttribute(shader.locs[SHADER_LOC_VERTEX_TEXCOORD02], 2, RL_FLOAT, 0, 0, 0);
+            rlEnableVertexAttribute(shader.locs[SHADER_LOC_VERTEX_TEXCOORD02]);
         }
-
         if (mesh.indices != NULL) rlEnableVertexBufferElement(mesh.vboId[6]);
     }
 
-    // Calculate model-view-projection matrix (MVP)
-    Matrix matModelViewProjection = MatrixIdentity();
-    matModelViewProjection = MatrixMultiply(matModelView, matProjection);
-    
+    // Instance attributes, looked up by name
+    for (const InstanceAttribute& attribute : stream->layout->attributes)
+    {
+        int location = rlGetLocationAttrib(shader.id, attribute.name);
+        binding.locations.push_back(location);
+        if (location == -1) continue;
+        for (int j = 0; j < attribute.locations; j++) rlEnableVertexAttribute(location + j);
+    }
+    SetInstanceBindingFirst(stream, &binding, 0);
+    SetInstanceBindingDivisor(stream, &binding, binding.divisor);
+
+    rlDisableVertexArray();
+    rlDisableVertexBuffer();
+    rlDisableVertexBufferElement();
+
+    return &binding;
+}
+
+void UploadInstanceStream(InstanceStream *stream, const void *instances, int count)
+{
+    if (count <= 0) return;
+    int stride = stream->layout->stride;
+
+    // Grow to the new high-water mark, otherwise orphan the old storage so we never wait on the GPU
+    bool grow = count > stream->capacity;
+    if (grow)
+    {
+        if (stream->capacity > 0) instanceStats.buffersCreated++;
+        stream->capacity = std::max(count, stream->capacity*2);
+    }
+
+    glBindBuffer(GL_ARRAY_BUFFER, stream->vboId);
+    glBufferData(GL_ARRAY_BUFFER, stream->capacity*stride, NULL, GL_STREAM_DRAW);
+    glBufferSubData(GL_ARRAY_BUFFER, 0, count*stride, instances);
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+
+    instanceStats.bytesUploaded += count*stride;
+}
+
+void DrawInstanceStream(Mesh mesh, Material material, InstanceStream *stream, int instances, int first = 0)
+{
+    if (instances <= 0) return;
+
+    int MAX_MATERIAL_MAPS = 12;
+
+    // In multiview mode every instance is drawn once per view
+    int viewCount = multiview.enabled ? multiview.viewCount : 1;
+
+    // Bind shader program
+    rlEnableShader(material.shader.id);
+
+    // Upload view and projection matrices (if locations available)
+    // NOTE: At this point the modelview matrix just contains the view matrix (camera)
+    Matrix matView = rlGetMatrixModelview();
+    Matrix matProjection = rlGetMatrixProjection();
+    if (material.shader.locs[SHADER_LOC_MATRIX_VIEW] != -1) rlSetUniformMatrix(material.shader.locs[SHADER_LOC_MATRIX_VIEW], matView);
+    if (material.shader.locs[SHADER_LOC_MATRIX_PROJECTION] != -1) rlSetUniformMatrix(material.shader.locs[SHADER_LOC_MATRIX_PROJECTION], matProjection);
+
+    // Upload model normal matrix (if locations available)
+    if (material.shader.locs[SHADER_LOC_MATRIX_NORMAL] != -1) rlSetUniformMatrix(material.shader.locs[SHADER_LOC_MATRIX_NORMAL], MatrixIdentity());
+
     // Send combined model-view-projection matrix to shader
-    rlSetUniformMatrix(material.shader.locs[SHADER_LOC_MATRIX_MVP], matModelViewProjection);
-    
-    if (mesh.indices != NULL) rlDrawVertexArrayElementsInstanced(0, mesh.triangleCount*3, 0, instances);
-    else rlDrawVertexArrayInstanced(0, mesh.vertexCount, instances);
+    // NOTE: Instance transformations are computed in the shader
+    Matrix matModelView = MatrixMultiply(rlGetMatrixTransform(), matView);
+    if (material.shader.locs[SHADER_LOC_MATRIX_MVP] != -1) rlSetUniformMatrix(material.shader.locs[SHADER_LOC_MATRIX_MVP], MatrixMultiply(matModelView, matProjection));
+
+    // Bind active texture maps (if available)
+    for (int i = 0; i < MAX_MATERIAL_MAPS; i++)
+    {
+        if (material.maps[i].texture.id > 0)
+        {
+            // Select current shader texture slot
+            rlActiveTextureSlot(i);
+
+            // Enable texture for active slot
+            if ((i == MATERIAL_MAP_IRRADIANCE) ||
+                (i == MATERIAL_MAP_PREFILTER) ||
+                (i == MATERIAL_MAP_CUBEMAP)) rlEnableTextureCubemap(material.maps[i].texture.id);
+            else rlEnableTexture(material.maps[i].texture.id);
+
+            rlSetUniform(material.shader.locs[SHADER_LOC_MAP_ALBEDO + i], &i, SHADER_UNIFORM_INT, 1);
+        }
+    }
+
+    InstanceBinding *binding = GetInstanceBinding(mesh, material.shader, stream);
+    rlEnableVertexArray(binding->vaoId);
+
+    // Switching between multiview and per view rendering only changes the divisor
+    if (binding->divisor != viewCount) SetInstanceBindingDivisor(stream, binding, viewCount);
+    if (binding->first != first) SetInstanceBindingFirst(stream, binding, first);
+
+    const PackedMeshFormat *packed = GetPackedMeshFormat(mesh);
+    if (packed != NULL) glDrawElementsInstanced(GL_TRIANGLES, mesh.triangleCount*3, packed->indexType, 0, instances*viewCount);
+    else if (mesh.indices != NULL) rlDrawVertexArrayElementsInstanced(0, mesh.triangleCount*3, 0, instances*viewCount);
+    else rlDrawVertexArrayInstanced(0, mesh.vertexCount, instances*viewCount);
+
+    instanceStats.drawCalls++;
+    instanceStats.instances += instances*viewCount;
 
     // Unbind all binded texture maps
     for (int i = 0; i < MAX_MATERIAL_MAPS; i++)
@@ -294,19 +730,78 @@ void DrawMeshInstancedC(Mesh mesh, Material material, Matrix *transforms, Vector
         else rlDisableTexture();
     }
 
-    // Disable all possible vertex array objects (or VBOs)
+    // Disable vertex array object and shader program
     rlDisableVertexArray();
-    rlDisableVertexBuffer();
-    rlDisableVertexBufferElement();
-
-    // Disable shader program
     rlDisableShader();
+}
+
+void UnloadInstanceStreams()
+{
+    for (auto& entry : instanceStreams)
+    {
+        for (auto& binding : entry.second.bindings) rlUnloadVertexArray(binding.second.vaoId);
+        rlUnloadVertexBuffer(entry.second.vboId);
+    }
+    instanceStreams.clear();
+    instanceStaging = std::vector<ModelInstance>();
+}
 
-    // Remove instance transforms buffer
-    rlUnloadVertexBuffer(instanceTransformsVboId);
-    rlUnloadVertexBuffer(instanceColorsVboId);
-    RL_FREE(instanceTransforms);
-    RL_FREE(instanceColors);
+// Before unloading a mesh or shader (0 for neither) on its own, GL reuses freed ids and the streams of the
+// next mesh or shader with that id must not find these
+void UnloadInstanceStreamsOf(unsigned int meshVboId, unsigned int shaderId)
+{
+    for (auto it = instanceStreams.begin(); it != instanceStreams.end();)
+    {
+        InstanceStream& stream = it->second;
+        if ((meshVboId != 0 && std::get<0>(it->first) == meshVboId) || (shaderId != 0 && std::get<1>(it->first) == shaderId))
+        {
+            for (auto& binding : stream.bindings) rlUnloadVertexArray(binding.second.vaoId);
+            rlUnloadVertexBuffer(stream.vboId);
+            it = instanceStreams.erase(it);
+            continue;
+        }
+        // E.g. the shadow pass of a stream drawn with another shader
+        auto binding = stream.bindings.find(shaderId);
+        if (shaderId != 0 && binding != stream.bindings.end())
+        {
+            rlUnloadVertexArray(binding->second.vaoId);
+            stream.bindings.erase(binding);
+        }
+        ++it;
+    }
+}
+
+ModelInstance ToModelInstance(Matrix transform, Vector4 color)
+{
+    return ModelInstance{ MatrixToFloatV(transform), color };
+}
+
+void DrawMeshInstancedC(Mesh mesh, Material material, Matrix *transforms, Vector4 *colors, int instances)
+{
+    // Check instancing
+    if (instances <= 0) return;
+
+    if ((int)instanceStaging.size() < instances) instanceStaging.resize(instances);
+    for (int i = 0; i < instances; i++) instanceStaging[i] = ToModelInstance(transforms[i], colors[i]);
+
+    InstanceStream *stream = GetInstanceStream(mesh, material, MODEL_INSTANCE_LAYOUT, 0);
+    UploadInstanceStream(stream, instanceStaging.data(), instances);
+    DrawInstanceStream(mesh, material, stream, instances);
+}
+
+// IDLE ----------
+// Frames where the quilt pass or presentation was skipped because nothing changed (see main.cpp)
+typedef struct IdleStats {
+    long frames;
+    long quiltsSkipped;
+    long idleFrames;
+} IdleStats;
+IdleStats idleStats = { 0 };
+
+void DrawIdleStats(int posX, int posY, int fontSize)
+{
+    DrawText(TextFormat("%li/%li SKIP", idleStats.quiltsSkipped, idleStats.frames),
+            posX, posY, fontSize, idleStats.quiltsSkipped > 0 ? LIME : ORANGE);
 }
 
 std::string slurp(std::ifstream& in) {
@@ -315,25 +810,38 @@ std::string slurp(std::ifstream& in) {
     return sstr.str();
 }
 
-Shader LoadShaderSingleFile(const std::string path) {
+// From source already in memory, e.g. read ahead on another thread (see ResourceCache::Prefetch)
+Shader LoadShaderSingleSource(const std::string path, const std::string& shaderStr, const std::string defines = "") {
     Shader shader = { 0 };
 
     std::cout << "INFO: Loading shader '" + path + "'\n";
 
-    std::ifstream shaderFile(path);
-    std::string shaderStr(slurp(shaderFile));
+    // Shaders opt into the multiview prelude by referencing MULTIVIEW
+    std::string preludeStr;
+    bool useMultiview = multiview.enabled && shaderStr.find("MULTIVIEW") != std::string::npos;
+    if (useMultiview) {
+        std::ifstream preludeFile("./Shaders/multiview.glsl");
+        preludeStr = "#define MULTIVIEW_MAX_VIEWS " + std::to_string(MULTIVIEW_MAX_VIEWS) + "\n" + slurp(preludeFile);
+    }
 
-    std::string vertexShaderStr = "#version 310 es\n#define VERTEX\n" + shaderStr;
-    std::string fragmentShaderStr = "#version 310 es\n#define FRAGMENT\n" + shaderStr;
+    std::string vertexShaderStr = "#version 310 es\n#define VERTEX\n" + defines + preludeStr + shaderStr;
+    std::string fragmentShaderStr = "#version 310 es\n#define FRAGMENT\n" + defines + preludeStr + shaderStr;
 
-    const char *vShaderStr = (vertexShaderStr.c_str());
-    const char *fShaderStr = (fragmentShaderStr.c_str());
+    shader = shaderCache.Load(vertexShaderStr, fragmentShaderStr);
 
-    shader = LoadShaderFromMemory(vShaderStr, fShaderStr);
+    if (useMultiview) {
+        unsigned int blockIndex = glGetUniformBlockIndex(shader.id, "Multiview");
+        if (blockIndex != GL_INVALID_INDEX) glUniformBlockBinding(shader.id, blockIndex, MULTIVIEW_BINDING);
+    }
 
     return shader;
 }
 
+Shader LoadShaderSingleFile(const std::string path, const std::string defines = "") {
+    std::ifstream shaderFile(path);
+    return LoadShaderSingleSource(path, slurp(shaderFile), defines);
+}
+
 Mesh GenMeshPlaneY(float width, float length, int resX, int resZ)
 {
     Mesh mesh = { 0 };
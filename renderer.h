@@ -0,0 +1,251 @@
+#ifndef RENDERER_H
+#define RENDERER_H
+
+#include "raylib.h"
+#include "raymath.h"
+#include "rlgl.h"
+
+#include <cmath>
+#include <vector>
+#include <iostream>
+
+#include "config.h"
+#include "raylib_extensions.h"
+#include "drawlist.h"
+#include "quilt.h"
+#include "interleaver.h"
+#include "synthesis.h"
+#include "profiler.h"
+#include "scene.h"
+#include "culling.h"
+
+// Commands with fewer instances aren't worth a BVH, most of them are visible in every view anyway
+#define VIEW_CULLING_MIN_INSTANCES 4096
+
+// Everything between a scene and the screen: builds the scene's draws, renders them into the quilt
+// (all views, multiview or sparse key views + synthesis) and interleaves the quilt.
+// Shared by the app, headless runs and the benchmark. Owns GL objects, delete before CloseWindow.
+class QuiltRenderer {
+private:
+    Scene* scene;
+    AppOptions options;
+    LKGConfig config;
+    FrameProfiler& profiler;
+
+    std::pair<float, float> angleDistance;
+    int viewStride;
+    QuiltLayout quiltLayout;
+    Camera3D camera = { 0 };
+
+    Quilt* quilt = NULL;
+    bool quiltInvalid = true;   // Set whenever the quilt is reallocated, forces the next quilt pass
+    Interleaver* interleaver = NULL;
+    ViewSynthesizer* synthesizer = NULL;
+
+    DrawList drawList;
+    ViewConeCuller culler;
+    unsigned long lastContentVersion = 0;
+    unsigned long long lastDrawHash = 0;
+
+    float ViewOffset(int i) {
+        float movementAmount = tan((config.viewCone/2.0f) * DEG2RAD) * angleDistance.second;
+        return -movementAmount + ((movementAmount * 2)/quilt->GetViewCount()) * i;
+    }
+    float TileAspect() {
+        return (float)quilt->tileWidth/(float)quilt->tileHeight;
+    }
+    Matrix GetViewProjection(int i) {
+        Camera3D viewCamera = camera;
+        viewCamera.position.x = ViewOffset(i);
+        viewCamera.target.x = ViewOffset(i);
+        return GetMatrixViewProjectionLG(viewCamera, TileAspect(), -ViewOffset(i));
+    }
+
+    // Render the frame's draw list into every view of target, views get their tile via BeginView
+    void RenderViews(Quilt* target, int (*viewIndex)(ViewSynthesizer*, int)) {
+        for (int i = target->GetViewCount() - 1; i >= 0; i--) {
+            target->BeginView(i, scene->GetClearColor());
+
+            float offset = ViewOffset(viewIndex(synthesizer, i));
+            camera.position.x = offset;
+            camera.target.x = offset;
+
+            BeginMode3DLG(camera, TileAspect(), -offset);
+                drawList.Replay();
+            EndMode3D();
+            target->EndView();
+        }
+    }
+public:
+    QuiltRenderer(Scene* scene, const AppOptions& options, const LKGConfig& config,
+            int screenWidth, int screenHeight, FrameProfiler& profiler)
+        : options(options), config(config), profiler(profiler) {
+        //Load shaders
+        quiltLayout = options.layered ? QuiltLayout::Layered : QuiltLayout::Atlas;
+        InterleaveMode interleaveMode = options.lutCompare ? InterleaveMode::LutCompare
+            : (options.lut ? InterleaveMode::Lut : InterleaveMode::Analytic);
+        std::string quiltDefines = Quilt::GetShaderDefines(quiltLayout) + (options.quiltDebug ? "#define HOLOPLAY_DEBUG\n" : "");
+        interleaver = new Interleaver(interleaveMode, options.lutHighp, screenWidth, screenHeight, config, quiltDefines);
+
+        // Camera
+        camera.target = { 0, 0, 0 };
+        camera.up = { 0, 1.0f, 0 };
+        camera.fovy = 17.0f;
+        camera.projection = CAMERA_PERSPECTIVE;
+
+        SetScene(scene);
+        SetShadows(true);
+    }
+    ~QuiltRenderer() {
+        delete synthesizer;
+        delete quilt;
+        delete interleaver;
+    }
+    QuiltRenderer(const QuiltRenderer&) = delete;
+    QuiltRenderer& operator=(const QuiltRenderer&) = delete;
+
+    // Render another scene from the next RenderQuilt on, at its own view settings and quilt quality.
+    // The previous scene can be deleted afterwards, nothing of it is kept
+    void SetScene(Scene* scene) {
+        this->scene = scene;
+        angleDistance = scene->GetAngleDistance();
+        viewStride = options.viewStride > 0 ? options.viewStride : scene->GetViewStride();
+        if (options.multiview && viewStride > 1) {
+            std::cout << "WARNING: Multiview renders all views in one pass, ignoring view stride\n";
+            viewStride = 1;
+        }
+        camera.position = { 0, 0, angleDistance.second };
+
+        drawList.Reset();
+        lastContentVersion = 0;
+        lastDrawHash = 0;
+        SetQuality(scene->GetTiles(), scene->GetTileResolution());
+    }
+
+    // (Re)allocate the quilt and everything that depends on its tiles
+    void SetQuality(std::pair<int, int> tiles, std::pair<int, int> tileRes) {
+        delete quilt;
+        quilt = new Quilt(quiltLayout, tiles, tileRes);
+        quiltInvalid = true;
+        drawList.SetTileResolution(tileRes);
+
+        interleaver->SetTiles(tiles);
+
+        delete synthesizer;
+        synthesizer = NULL;
+        if (viewStride > 1) {
+            std::vector<float> offsets;
+            for (int i = 0; i < quilt->GetViewCount(); i++) offsets.push_back(ViewOffset(i));
+            synthesizer = new ViewSynthesizer(viewStride, tiles, tileRes, camera, offsets);
+        }
+
+        // The outermost views bound all of them (see ViewConeCuller)
+        culler = ViewConeCuller(GetViewProjection(0), GetViewProjection(quilt->GetViewCount() - 1));
+
+        // Views never move, so the multiview matrices are only uploaded when the quilt changes
+        if (options.multiview) {
+            Matrix viewProjections[MULTIVIEW_MAX_VIEWS];
+            Rectangle viewRects[MULTIVIEW_MAX_VIEWS];
+            for (int i = 0; i < quilt->GetViewCount() && i < MULTIVIEW_MAX_VIEWS; i++) {
+                viewProjections[i] = GetViewProjection(i);
+                viewRects[i] = quilt->GetViewRect(i);
+            }
+            UpdateMultiview(viewProjections, viewRects, quilt->GetViewCount(), quilt->GetWidth(), quilt->GetHeight());
+        }
+    }
+
+    // Draw the scenes' shadow passes, never with --no-shadows
+    void SetShadows(bool enabled) {
+        enabled = enabled && options.shadows;
+        if (enabled != drawList.GetShadowsEnabled()) quiltInvalid = true;
+        drawList.SetShadowsEnabled(enabled);
+    }
+
+    // Build the frame's draws (see Scene::Draw for time and alpha) and render the quilt if they changed
+    // since the last one. Returns whether the quilt was rendered
+    bool RenderQuilt(double time, float alpha) {
+        // Dirty tracking: the quilt is only re-rendered when what the scene submits changed
+        unsigned long contentVersion = scene->GetContentVersion();
+        bool quiltDirty = !options.idle || quiltInvalid || contentVersion == 0 || contentVersion != lastContentVersion;
+        profiler.BeginStage(ProfileStage::Build, false);
+        if (quiltDirty) {
+            // Build the frame's draw list once, from the center camera (used for CPU side work e.g. line directions)
+            drawList.Clear();
+            camera.position.x = 0;
+            camera.target.x = 0;
+            BeginMode3DLG(camera, TileAspect(), 0);
+                //Rotate stand angle
+                rlPushMatrix();
+                rlRotatef(angleDistance.first, 1, 0, 0);
+                    scene->Draw(drawList, time, alpha);
+                rlPopMatrix();
+            EndMode3D();
+            drawList.GetArena().Reset();
+
+            if (options.culling) drawList.Cull(culler);
+
+            if (contentVersion == 0) {
+                unsigned long long drawHash = drawList.GetHash();
+                quiltDirty = !options.idle || quiltInvalid || drawHash != lastDrawHash;
+                lastDrawHash = drawHash;
+            }
+            lastContentVersion = contentVersion;
+
+            // Synthesized views need everything their key views could show, key views can't be culled on their own
+            if (quiltDirty && options.viewCulling && synthesizer == NULL) drawList.BuildViewBVH(VIEW_CULLING_MIN_INSTANCES);
+        }
+        profiler.EndStage();
+
+        ResetInstanceStats();
+        instanceStats.instancesCulled = drawList.GetCulledCount();
+        instanceStats.arenaBytes = drawList.GetArena().GetLastUsed();
+        instanceStats.arenaBlocksAllocated = drawList.GetArena().GetBlocksAllocated();
+        idleStats.frames++;
+        if (!quiltDirty) {
+            idleStats.quiltsSkipped++;
+            return false;
+        }
+
+        profiler.BeginStage(ProfileStage::Upload, true);
+        drawList.Upload();
+        profiler.EndStage();
+
+        profiler.BeginStage(ProfileStage::Quilt, true);
+        if (synthesizer != NULL) {
+            // Only the key views are rendered, with depth
+            Quilt* keyViews = synthesizer->GetKeyViews();
+            keyViews->Begin(scene->GetClearColor());
+                RenderViews(keyViews, [](ViewSynthesizer* synthesizer, int k) { return synthesizer->GetKeyView(k); });
+            keyViews->End();
+        }
+
+        quilt->Begin(scene->GetClearColor());
+            if (synthesizer != NULL) {
+                synthesizer->Synthesize(quilt, scene->GetClearColor());
+            } else if (options.multiview) {
+                // Single pass, per view matrices come from the multiview uniform block
+                BeginMode3DLG(camera, TileAspect(), 0);
+                    drawList.Replay();
+                EndMode3D();
+            } else {
+                RenderViews(quilt, [](ViewSynthesizer*, int i) { return i; });
+            }
+        quilt->End();
+        profiler.EndStage();
+
+        quiltInvalid = false;
+        return true;
+    }
+
+    // Draw the lenticular image, between BeginDrawing (or BeginTextureMode) and EndDrawing
+    void Interleave() {
+        profiler.BeginStage(ProfileStage::Interleave, true);
+        interleaver->Draw(quilt);
+        profiler.EndStage();
+    }
+
+    Quilt* GetQuilt() { return quilt; }
+    DrawList& GetDrawList() { return drawList; }
+};
+
+#endif
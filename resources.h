@@ -0,0 +1,367 @@
+#ifndef RESOURCES_H
+#define RESOURCES_H
+
+#include "raylib.h"
+#include "rlgl.h"
+
+#include <GLES3/gl3.h>
+
+#include <map>
+#include <cmath>
+#include <deque>
+#include <mutex>
+#include <chrono>
+#include <string>
+#include <thread>
+#include <vector>
+#include <condition_variable>
+#include <fstream>
+#include <utility>
+#include <iostream>
+#include <algorithm>
+#include <functional>
+
+#include "packedmesh.h"
+#include "raylib_extensions.h"
+
+// A texture from ResourceCache::AcquireTexture. Loaded in the background, until then it is a 1x1 transparent
+// placeholder (the text shader discards it, nothing is drawn)
+struct TextureAsset {
+    Texture2D texture = { 0 };
+    bool ready = false;
+    int references = 0;
+    unsigned int generation = 0;    // Tells a reacquired texture from loads still in flight for a released one
+};
+
+// What scenes hold on to, valid until released. Render thread only
+class TextureHandle {
+private:
+    const TextureAsset* asset = NULL;
+public:
+    TextureHandle() { }
+    TextureHandle(const TextureAsset* asset) : asset(asset) { }
+
+    bool IsReady() const { return asset != NULL && asset->ready; }
+    // The placeholder until ready, so read it again every frame (e.g. into the material)
+    Texture2D Get() const { return asset != NULL ? asset->texture : Texture2D{ 0 }; }
+    const TextureAsset* GetAsset() const { return asset; }
+};
+
+// Shaders, textures and meshes shared by the scenes, loaded the first time a scene acquires them and
+// unloaded when the last one releases them. Scenes only set up per scene state, e.g. uniform values,
+// in Scene::Activate, another scene may be using the same shader.
+// Textures are read and decoded on worker threads, and uploaded by UploadTextures within a time budget per frame.
+// Everything is GL thread only, except Prefetch which only reads files (see SceneManager::Preload)
+class ResourceCache {
+private:
+    template <typename T>
+    struct Entry {
+        T resource;
+        int references;
+    };
+
+    std::map<std::pair<std::string, std::string>, Entry<Shader>> shaders;  // By path and defines
+    std::map<std::string, TextureAsset> textures;                           // By path
+    std::map<std::string, Entry<Mesh>> meshes;                              // By a key naming the generator and its arguments
+    std::map<std::string, Entry<PackedMesh>> models;                        // By path
+
+    // Read ahead by Prefetch, shader sources stay (the same file can be compiled with other defines),
+    // images are freed once uploaded
+    std::mutex prefetchMutex;
+    std::map<std::string, std::string> sources;
+    std::map<std::string, Image> images;
+
+    // Texture loading: workers decode queued images to RGBA, the GL thread uploads them in bands of rows
+    struct ImageJob {
+        std::string path;
+        unsigned int generation;
+        Image image;
+    };
+    static const int LOAD_WORKERS = 2;
+    static const int UPLOAD_BAND_BYTES = 64*1024;
+
+    std::mutex loadMutex;
+    std::condition_variable loadCondition;
+    std::deque<ImageJob> queued;
+    std::deque<ImageJob> decoded;
+    int decoding = 0;
+    bool stopping = false;
+    std::vector<std::thread> workers;
+
+    Texture2D placeholder = { 0 };
+    unsigned int generations = 0;
+    bool uploading = false;
+    ImageJob upload;
+    Texture2D uploadTexture = { 0 };
+    int uploadRow = 0;
+
+    void Work() {
+        std::unique_lock<std::mutex> lock(loadMutex);
+        while (true) {
+            loadCondition.wait(lock, [this]() { return stopping || !queued.empty(); });
+            if (stopping) return;
+            ImageJob job = queued.front();
+            queued.pop_front();
+            decoding++;
+            lock.unlock();
+
+            if (job.image.data == NULL) job.image = LoadImage(job.path.c_str());
+            if (job.image.data != NULL) ImageFormat(&job.image, PIXELFORMAT_UNCOMPRESSED_R8G8B8A8);
+
+            lock.lock();
+            decoding--;
+            decoded.push_back(job);
+        }
+    }
+
+    // NULL once the texture was released, or released and acquired again
+    TextureAsset* FindAsset(const ImageJob& job) {
+        auto it = textures.find(job.path);
+        if (it == textures.end() || it->second.generation != job.generation) return NULL;
+        return &it->second;
+    }
+
+    void UnloadPlaceholder() {
+        if (placeholder.id != 0) UnloadTexture(placeholder);
+        placeholder = { 0 };
+    }
+
+    static bool HasExtension(const std::string& path, const std::string& extension) {
+        return path.size() > extension.size() && path.compare(path.size() - extension.size(), extension.size(), extension) == 0;
+    }
+
+    std::string GetSource(const std::string& path) {
+        {
+            std::lock_guard<std::mutex> lock(prefetchMutex);
+            auto it = sources.find(path);
+            if (it != sources.end()) return it->second;
+        }
+        std::ifstream file(path);
+        std::string source = slurp(file);
+        std::lock_guard<std::mutex> lock(prefetchMutex);
+        return sources[path] = source;
+    }
+public:
+    ~ResourceCache() {
+        {
+            std::lock_guard<std::mutex> lock(loadMutex);
+            stopping = true;
+        }
+        loadCondition.notify_all();
+        for (std::thread& worker : workers) worker.join();
+
+        for (auto& entry : images) UnloadImage(entry.second);
+        for (ImageJob& job : queued) UnloadImage(job.image);
+        for (ImageJob& job : decoded) UnloadImage(job.image);
+        if (uploading) UnloadImage(upload.image);
+    }
+
+    // Read the file into memory, safe to call from any thread. Mesh files are mapped when loaded,
+    // they're only read ahead into the page cache
+    void Prefetch(const std::string& path) {
+        if (HasExtension(path, ".lkgm")) {
+            PrefetchPackedMesh(path);
+            return;
+        }
+        {
+            std::lock_guard<std::mutex> lock(prefetchMutex);
+            if (sources.count(path) || images.count(path)) return;
+        }
+        if (HasExtension(path, ".png")) {
+            Image image = LoadImage(path.c_str());
+            std::lock_guard<std::mutex> lock(prefetchMutex);
+            if (!images.emplace(path, image).second) UnloadImage(image);
+        } else {
+            std::ifstream file(path);
+            std::string source = slurp(file);
+            std::lock_guard<std::mutex> lock(prefetchMutex);
+            sources.emplace(path, source);
+        }
+    }
+
+    // Compiled with LoadShaderSingleFile's defines, with the locations every instanced shader uses
+    Shader AcquireShader(const std::string& path, const std::string& defines = "") {
+        Entry<Shader>& entry = shaders[std::make_pair(path, defines)];
+        if (entry.references++ > 0) return entry.resource;
+
+        Shader shader = LoadShaderSingleSource(path, GetSource(path), defines);
+        shader.locs[SHADER_LOC_MATRIX_VIEW] = GetShaderLocation(shader, "matView");
+        shader.locs[SHADER_LOC_MATRIX_PROJECTION] = GetShaderLocation(shader, "matProjection");
+        shader.locs[SHADER_LOC_MATRIX_MODEL] = GetShaderLocationAttrib(shader, "matModel");
+        shader.locs[SHADER_LOC_COLOR_DIFFUSE] = GetShaderLocationAttrib(shader, "colDiffuse");
+        shader.locs[SHADER_LOC_MAP_ALBEDO] = GetShaderLocation(shader, "texture1");
+        return entry.resource = shader;
+    }
+    void ReleaseShader(Shader shader) {
+        for (auto it = shaders.begin(); it != shaders.end(); ++it) {
+            if (it->second.resource.id != shader.id) continue;
+            if (--it->second.references > 0) return;
+            UnloadInstanceStreamsOf(0, shader.id);
+            UnloadShader(shader);
+            shaders.erase(it);
+            return;
+        }
+    }
+
+    // Starts loading the texture unless another scene already did, the handle shows a placeholder until then
+    TextureHandle AcquireTexture(const std::string& path) {
+        TextureAsset& asset = textures[path];
+        if (asset.references++ > 0) {
+            // Already loaded (or loading), a preload read the file again for nothing
+            std::lock_guard<std::mutex> lock(prefetchMutex);
+            auto it = images.find(path);
+            if (it != images.end()) {
+                UnloadImage(it->second);
+                images.erase(it);
+            }
+            return TextureHandle(&asset);
+        }
+
+        if (placeholder.id == 0) {
+            unsigned char transparent[4] = { 0, 0, 0, 0 };
+            placeholder = { rlLoadTexture(transparent, 1, 1, PIXELFORMAT_UNCOMPRESSED_R8G8B8A8, 1), 1, 1, 1,
+                PIXELFORMAT_UNCOMPRESSED_R8G8B8A8 };
+        }
+        asset.texture = placeholder;
+        asset.generation = ++generations;
+
+        ImageJob job = { path, asset.generation, Image{ 0 } };
+        {
+            std::lock_guard<std::mutex> lock(prefetchMutex);
+            auto it = images.find(path);
+            if (it != images.end()) {
+                job.image = it->second;
+                images.erase(it);
+            }
+        }
+        {
+            std::lock_guard<std::mutex> lock(loadMutex);
+            queued.push_back(job);
+            while (workers.size() < LOAD_WORKERS) workers.push_back(std::thread(&ResourceCache::Work, this));
+        }
+        loadCondition.notify_one();
+        return TextureHandle(&asset);
+    }
+    void ReleaseTexture(TextureHandle texture) {
+        for (auto it = textures.begin(); it != textures.end(); ++it) {
+            if (&it->second != texture.GetAsset()) continue;
+            if (--it->second.references > 0) return;
+            // Loads still in flight are dropped when they're done (see FindAsset)
+            if (it->second.ready) UnloadTexture(it->second.texture);
+            textures.erase(it);
+            // Recreated by the next AcquireTexture
+            if (textures.empty()) UnloadPlaceholder();
+            return;
+        }
+    }
+
+    // GL thread, once per frame. Uploads decoded textures for about budget milliseconds, at least one band of
+    // rows so large textures make progress at any budget. Returns whether textures are still loading
+    bool UploadTextures(float budget) {
+        auto start = std::chrono::steady_clock::now();
+        do {
+            if (!uploading) {
+                {
+                    std::lock_guard<std::mutex> lock(loadMutex);
+                    if (decoded.empty()) break;
+                    upload = decoded.front();
+                    decoded.pop_front();
+                }
+                if (upload.image.data == NULL || FindAsset(upload) == NULL) {
+                    if (upload.image.data == NULL) std::cout << "WARNING: Couldn't load texture '" << upload.path << "'\n";
+                    UnloadImage(upload.image);
+                    continue;
+                }
+                uploadTexture = { rlLoadTexture(NULL, upload.image.width, upload.image.height, PIXELFORMAT_UNCOMPRESSED_R8G8B8A8, 1),
+                    upload.image.width, upload.image.height, 1, PIXELFORMAT_UNCOMPRESSED_R8G8B8A8 };
+                uploadRow = 0;
+                uploading = true;
+            }
+
+            int rowBytes = upload.image.width*4;
+            int rows = std::min(std::max(1, UPLOAD_BAND_BYTES/rowBytes), upload.image.height - uploadRow);
+            glBindTexture(GL_TEXTURE_2D, uploadTexture.id);
+            glTexSubImage2D(GL_TEXTURE_2D, 0, 0, uploadRow, upload.image.width, rows, GL_RGBA, GL_UNSIGNED_BYTE,
+                (const unsigned char *)upload.image.data + uploadRow*rowBytes);
+            glBindTexture(GL_TEXTURE_2D, 0);
+            uploadRow += rows;
+
+            if (uploadRow == upload.image.height) {
+                TextureAsset* asset = FindAsset(upload);
+                if (asset != NULL) {
+                    asset->texture = uploadTexture;
+                    asset->ready = true;
+                } else {
+                    UnloadTexture(uploadTexture);
+                }
+                UnloadImage(upload.image);
+                uploading = false;
+            }
+        } while (std::chrono::duration<float, std::milli>(std::chrono::steady_clock::now() - start).count() < budget);
+        return IsLoading();
+    }
+    bool IsLoading() {
+        std::lock_guard<std::mutex> lock(loadMutex);
+        return uploading || decoding > 0 || !queued.empty() || !decoded.empty();
+    }
+    // Blocks until every texture acquired so far is uploaded, for runs that must not show placeholders
+    void FinishLoading() {
+        while (UploadTextures(INFINITY)) std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+
+    // generate runs only for the first scene acquiring key, e.g. "cube 1.5" and a GenMeshCube(1.5f, ...)
+    Mesh AcquireMesh(const std::string& key, std::function<Mesh()> generate) {
+        Entry<Mesh>& entry = meshes[key];
+        if (entry.references++ > 0) return entry.resource;
+        return entry.resource = generate();
+    }
+    void ReleaseMesh(Mesh mesh) {
+        for (auto it = meshes.begin(); it != meshes.end(); ++it) {
+            if (it->second.resource.vboId[0] != mesh.vboId[0]) continue;
+            if (--it->second.references > 0) return;
+            UnloadInstanceStreamsOf(mesh.vboId[0], 0);
+            UnloadMesh(mesh);
+            meshes.erase(it);
+            return;
+        }
+    }
+
+    // Not loaded when the file is missing (see LoadPackedMesh), release it all the same
+    PackedMesh AcquirePackedMesh(const std::string& path) {
+        Entry<PackedMesh>& entry = models[path];
+        if (entry.references++ > 0) return entry.resource;
+        return entry.resource = LoadPackedMesh(path);
+    }
+    void ReleasePackedMesh(const PackedMesh& mesh) {
+        auto it = models.find(mesh.path);
+        if (it == models.end() || --it->second.references > 0) return;
+        UnloadPackedMesh(it->second.resource);
+        models.erase(it);
+    }
+
+    // GL thread, after the scenes were deleted and before the GL context is. The cache is a global, its
+    // destructor runs too late to delete GL objects
+    void Unload() {
+        UnloadPlaceholder();
+        if (uploading) {
+            UnloadTexture(uploadTexture);
+            UnloadImage(upload.image);
+            uploading = false;
+        }
+    }
+
+    // Loaded (referenced) resources, for the log
+    std::string GetSummary() {
+        return std::to_string(shaders.size()) + " shaders, " + std::to_string(textures.size()) + " textures, "
+            + std::to_string(meshes.size() + models.size()) + " meshes";
+    }
+};
+ResourceCache resources;
+
+// Materials only own their maps array, the shader and textures in it belong to the resource cache
+void UnloadMaterialMaps(Material material)
+{
+    MemFree(material.maps);
+}
+
+#endif
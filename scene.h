@@ -1,10 +1,37 @@
 #ifndef SCENE_H
 #define SCENE_H
 
+#include <ctime>
+
+#include "drawlist.h"
+#include "snapshot.h"
+
+// Wall clock for scenes that show the time, pinned (to this many seconds since the epoch)
+// for headless runs so their output is reproducible
+std::time_t fixedWallTime = 0;
+std::time_t GetWallTime() {
+    return fixedWallTime != 0 ? fixedWallTime : std::time(nullptr);
+}
+
 class Scene {
 public:
-    virtual void Update() { };
-    virtual void Draw() { };
+    virtual ~Scene() { }
+    // Called on the render thread when the scene becomes the shown one, before its first Draw. Shaders come
+    // from the shared ResourceCache and the next scene may be constructed while this one is still shown,
+    // so uniform values and GL state are set here rather than in the constructor
+    virtual void Activate() { }
+    // Advance the simulation by one fixed step (see SceneClock), deltaTime is always the same length
+    virtual void Update(float deltaTime) { };
+    // Update may run on a simulation thread (see SimulationThread) when everything Draw reads from it
+    // is handed over through a SnapshotBuffer. Scenes without simulation state are trivially safe
+    virtual bool SupportsThreadedUpdate() { return false; }
+    // Build this frame's draws, called once per frame (not per view) with the frame's scene time.
+    // alpha is how far the frame is from the previous Update step to the last one, for interpolating motion
+    virtual void Draw(DrawList& list, double time, float alpha) { };
+
+    // Change this whenever what Draw would submit changes, unchanged versions skip Draw and the quilt pass.
+    // 0 means untracked, the frame's draw list is hashed instead
+    virtual unsigned long GetContentVersion() { return 0; }
 
     virtual std::pair<float, float> GetAngleDistance() { return std::pair<float, float>(25.0f, 20.0f); }
     virtual Color GetClearColor() { return Color{225,225,225,255}; }
@@ -17,6 +44,10 @@ public:
         return std::pair<int, int>(315, 420);
         //return std::pair<int, int>(420, 560);
     }
+    // Render every n-th view and synthesize the rest from depth (see ViewSynthesizer), 1 renders all views
+    virtual int GetViewStride() {
+        return 1;
+    }
     virtual bool ShowFPS() {
         return true;
     }
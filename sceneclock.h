@@ -0,0 +1,78 @@
+#ifndef SCENECLOCK_H
+#define SCENECLOCK_H
+
+#include <cmath>
+#include <chrono>
+#include <algorithm>
+
+// Where scene time comes from. The app reads the steady clock, headless runs and the benchmark
+// step a manual one so every run sees exactly the same times
+class TimeSource {
+public:
+    virtual ~TimeSource() { }
+    // Seconds from an arbitrary origin, safe to call from any thread
+    virtual double Now() = 0;
+};
+
+class SteadyTimeSource : public TimeSource {
+private:
+    std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+public:
+    double Now() {
+        return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    }
+};
+
+class ManualTimeSource : public TimeSource {
+private:
+    double now;
+public:
+    ManualTimeSource(double now = 0.0) : now(now) { }
+    void Set(double now) { this->now = now; }
+    void Advance(double seconds) { now += seconds; }
+    double Now() { return now; }
+};
+
+// Fixed timestep clock: time from the source accumulates and is consumed in Update steps of the
+// same length whatever the frame rate, so gameplay doesn't change with quilt FPS. Frames show the
+// state alpha of the way from the previous step to the last one (see Scene::Draw).
+class SceneClock {
+private:
+    TimeSource* source;
+    double step;
+    int maxSteps;
+
+    double last;
+    double accumulator = 0.0;
+    long ticks = 0;
+public:
+    // maxSteps: most steps run per Advance, after a stall the rest of the backlog is dropped
+    SceneClock(TimeSource* source, double rate, int maxSteps = 8)
+        : source(source), step(1.0 / rate), maxSteps(maxSteps) {
+        last = source->Now();
+    }
+
+    // Number of Update steps due since the last call
+    int Advance() {
+        double now = source->Now();
+        accumulator += std::max(0.0, now - last);
+        last = now;
+
+        int steps = std::min((int)(accumulator / step), maxSteps);
+        accumulator -= steps * step;
+        if (accumulator >= step) accumulator = std::fmod(accumulator, step);
+        ticks += steps;
+        return steps;
+    }
+
+    double GetStep() { return step; }
+    long GetTicks() { return ticks; }
+    // Time of the last step
+    double GetTime() { return ticks * step; }
+    // Between 0 (previous step) and 1 (last step)
+    float GetAlpha() { return accumulator / step; }
+    // Scene time matching the interpolated state, one step behind GetTime
+    double GetRenderTime() { return std::max(0.0, (ticks - 1 + GetAlpha()) * step); }
+};
+
+#endif
@@ -0,0 +1,150 @@
+#ifndef SCENEGRAPH_H
+#define SCENEGRAPH_H
+
+#include "raylib.h"
+#include "raymath.h"
+
+#include <vector>
+#include <cstring>
+#include <algorithm>
+
+// Handle of a node in a SceneGraph
+typedef int SceneNode;
+#define NO_SCENE_NODE -1
+
+// A transform hierarchy kept between frames, instead of rebuilding every transform on rlgl's matrix stack.
+// Scenes create their nodes once, set the local transforms of what moved, and Update recomputes the world
+// matrices of changed nodes and their descendants once per frame. Setting a value a node already has
+// doesn't mark it changed, so scenes can set everything every frame.
+//
+// Local transforms are stored structure of arrays, one array per component, and composed in one
+// branch free loop over the range of changed nodes. Parents are created before their children, so a
+// single pass in index order propagates world matrices down the hierarchy.
+// Root nodes are relative to a base matrix, e.g. the rlgl transform a Scene::Draw is called with
+// (see SetBase).
+class SceneGraph {
+private:
+    std::vector<SceneNode> parents;
+    // Local transform: scale, then rotation (a quaternion), then translation, like rlScalef, rlRotatef
+    // and rlTranslatef pushed in the opposite order
+    std::vector<float> tx, ty, tz;
+    std::vector<float> rx, ry, rz, rw;
+    std::vector<float> sx, sy, sz;
+
+    std::vector<Matrix> locals;
+    std::vector<Matrix> worlds;
+    Matrix base = MatrixIdentity();
+    std::vector<unsigned char> dirty;       // Local transform set since the last Update
+    std::vector<unsigned char> changed;     // World matrix recomputed by the last Update
+    SceneNode dirtyFirst = 0;               // Range of dirty nodes, empty when dirtyFirst > dirtyLast
+    SceneNode dirtyLast = -1;
+    int updated = 0;
+
+    void MarkDirty(SceneNode node) {
+        dirty[node] = 1;
+        dirtyFirst = std::min(dirtyFirst, node);
+        dirtyLast = std::max(dirtyLast, node);
+    }
+
+    // Composes every local transform in the range, clean ones too, so the loop has no branches and
+    // only reads and writes contiguous arrays
+    void ComposeLocals(SceneNode first, SceneNode last) {
+        const float *px = tx.data(), *py = ty.data(), *pz = tz.data();
+        const float *qx = rx.data(), *qy = ry.data(), *qz = rz.data(), *qw = rw.data();
+        const float *kx = sx.data(), *ky = sy.data(), *kz = sz.data();
+        Matrix *out = locals.data();
+        for (SceneNode i = first; i <= last; i++) {
+            float xx = qx[i]*qx[i], yy = qy[i]*qy[i], zz = qz[i]*qz[i];
+            float xy = qx[i]*qy[i], xz = qx[i]*qz[i], yz = qy[i]*qz[i];
+            float wx = qw[i]*qx[i], wy = qw[i]*qy[i], wz = qw[i]*qz[i];
+
+            Matrix& m = out[i];
+            m.m0 = (1.0f - 2.0f*(yy + zz))*kx[i]; m.m1 = 2.0f*(xy + wz)*kx[i];         m.m2 = 2.0f*(xz - wy)*kx[i];          m.m3 = 0.0f;
+            m.m4 = 2.0f*(xy - wz)*ky[i];         m.m5 = (1.0f - 2.0f*(xx + zz))*ky[i]; m.m6 = 2.0f*(yz + wx)*ky[i];          m.m7 = 0.0f;
+            m.m8 = 2.0f*(xz + wy)*kz[i];         m.m9 = 2.0f*(yz - wx)*kz[i];          m.m10 = (1.0f - 2.0f*(xx + yy))*kz[i]; m.m11 = 0.0f;
+            m.m12 = px[i];                       m.m13 = py[i];                        m.m14 = pz[i];                         m.m15 = 1.0f;
+        }
+    }
+public:
+    // Parents must exist already. Starts out as the identity
+    SceneNode Create(SceneNode parent = NO_SCENE_NODE) {
+        SceneNode node = parents.size();
+        parents.push_back(parent);
+        tx.push_back(0.0f); ty.push_back(0.0f); tz.push_back(0.0f);
+        rx.push_back(0.0f); ry.push_back(0.0f); rz.push_back(0.0f); rw.push_back(1.0f);
+        sx.push_back(1.0f); sy.push_back(1.0f); sz.push_back(1.0f);
+        locals.push_back(MatrixIdentity());
+        worlds.push_back(MatrixIdentity());
+        dirty.push_back(0);
+        changed.push_back(0);
+        MarkDirty(node);
+        return node;
+    }
+    SceneNode Create(SceneNode parent, Vector3 translation, Quaternion rotation = QuaternionIdentity(),
+            Vector3 scale = Vector3{ 1.0f, 1.0f, 1.0f }) {
+        SceneNode node = Create(parent);
+        SetTranslation(node, translation);
+        SetRotation(node, rotation);
+        SetScale(node, scale);
+        return node;
+    }
+
+    void SetTranslation(SceneNode node, Vector3 translation) {
+        if (tx[node] == translation.x && ty[node] == translation.y && tz[node] == translation.z) return;
+        tx[node] = translation.x; ty[node] = translation.y; tz[node] = translation.z;
+        MarkDirty(node);
+    }
+    void SetRotation(SceneNode node, Quaternion rotation) {
+        if (rx[node] == rotation.x && ry[node] == rotation.y && rz[node] == rotation.z && rw[node] == rotation.w) return;
+        rx[node] = rotation.x; ry[node] = rotation.y; rz[node] = rotation.z; rw[node] = rotation.w;
+        MarkDirty(node);
+    }
+    // Same as rlRotatef, angle in degrees
+    void SetRotation(SceneNode node, Vector3 axis, float angle) {
+        SetRotation(node, QuaternionFromAxisAngle(axis, angle*DEG2RAD));
+    }
+    void SetScale(SceneNode node, Vector3 scale) {
+        if (sx[node] == scale.x && sy[node] == scale.y && sz[node] == scale.z) return;
+        sx[node] = scale.x; sy[node] = scale.y; sz[node] = scale.z;
+        MarkDirty(node);
+    }
+
+    // Parent of the root nodes. Every node changes when it does, so set it every frame
+    void SetBase(const Matrix& base) {
+        if (memcmp(&this->base, &base, sizeof(Matrix)) == 0) return;
+        this->base = base;
+        for (SceneNode node = 0; node < (SceneNode)parents.size(); node++)
+            if (parents[node] == NO_SCENE_NODE) MarkDirty(node);
+    }
+
+    // Once per frame, before reading world matrices
+    void Update() {
+        std::fill(changed.begin(), changed.end(), 0);
+        updated = 0;
+        if (dirtyFirst > dirtyLast) return;
+
+        ComposeLocals(dirtyFirst, dirtyLast);
+        // Nothing before the first dirty node can change
+        for (SceneNode i = dirtyFirst; i < (SceneNode)parents.size(); i++) {
+            SceneNode parent = parents[i];
+            if (!dirty[i] && (parent == NO_SCENE_NODE || !changed[parent])) continue;
+            worlds[i] = MatrixMultiply(locals[i], parent == NO_SCENE_NODE ? base : worlds[parent]);
+            changed[i] = 1;
+            dirty[i] = 0;
+            updated++;
+        }
+        dirtyFirst = parents.size();
+        dirtyLast = -1;
+    }
+
+    const Matrix& GetWorld(SceneNode node) const { return worlds[node]; }
+    Vector3 TransformPoint(SceneNode node, Vector3 point) const { return Vector3Transform(point, worlds[node]); }
+    // World matrix recomputed by the last Update, e.g. to rebuild only the instances of moved nodes
+    bool HasChanged(SceneNode node) const { return changed[node] != 0; }
+
+    int GetNodeCount() const { return parents.size(); }
+    // Nodes the last Update recomputed
+    int GetUpdatedCount() const { return updated; }
+};
+
+#endif
@@ -0,0 +1,132 @@
+#ifndef SCENEMANAGER_H
+#define SCENEMANAGER_H
+
+#include "rlgl.h"
+
+#include <atomic>
+#include <string>
+#include <thread>
+#include <iostream>
+#include <algorithm>
+
+#include "scene.h"
+#include "scenes.h"
+#include "resources.h"
+
+// The shown scene, and switching to another at runtime without stalling the display.
+// A scene's files are read on a worker thread (see GetSceneFiles), then it is constructed on the render
+// thread in one frame (GL uploads and shader compiles, shared resources are already loaded) and swapped in
+// on the next one. After each switch the next scene of SCENE_NAMES is preloaded the same way.
+// Everything but the file reads happens on the render thread.
+class SceneManager {
+private:
+    Scene* current = NULL;
+    std::string currentName;
+    Scene* ready = NULL;            // Constructed, not shown yet
+    std::string readyName;
+    std::string requested;          // Shown once it's ready, empty when not switching
+
+    std::thread prefetch;
+    std::string prefetchName;       // Files being read, empty when idle
+    std::atomic<bool> prefetched{ false };
+public:
+    ~SceneManager() {
+        if (prefetch.joinable()) prefetch.join();
+        delete ready;
+        delete current;
+    }
+    SceneManager() { }
+    SceneManager(const SceneManager&) = delete;
+    SceneManager& operator=(const SceneManager&) = delete;
+
+    // The first scene, blocking. False for unknown names
+    bool Load(const std::string& name) {
+        Scene* scene = CreateScene(name);
+        if (scene == NULL) return false;
+        delete current;
+        current = scene;
+        currentName = name;
+        rlEnableBackfaceCulling();
+        current->Activate();
+        return true;
+    }
+
+    // Start reading the scene's files in the background, it's constructed by a later Update.
+    // Only one scene is read at a time, false if another one still is
+    bool Preload(const std::string& name) {
+        if (name == currentName || name == readyName || name == prefetchName) return true;
+        if (!prefetchName.empty() || !IsSceneName(name)) return false;
+
+        if (prefetch.joinable()) prefetch.join();
+        prefetchName = name;
+        prefetched = false;
+        prefetch = std::thread([this, name]() {
+            for (const std::string& path : GetSceneFiles(name)) resources.Prefetch(path);
+            prefetched.store(true, std::memory_order_release);
+        });
+        return true;
+    }
+
+    // Show the scene as soon as it's loaded (see Update), false for unknown names
+    bool SwitchTo(const std::string& name) {
+        if (!IsSceneName(name)) return false;
+        requested = name == currentName ? "" : name;
+        if (!requested.empty()) std::cout << "INFO: Switching to scene " << name << "\n";
+        return true;
+    }
+
+    // Once per frame on the render thread. Does at most one step (constructing a preloaded scene),
+    // returns true when the requested scene is ready for Swap
+    bool Update() {
+        if (!requested.empty() && ready != NULL && readyName == requested) return true;
+
+        if (!prefetchName.empty() && prefetched.load(std::memory_order_acquire)) {
+            prefetch.join();
+            // Preloading the next scene while another was requested: don't construct it, read the requested one
+            if (!requested.empty() && prefetchName != requested) {
+                prefetchName.clear();
+                Preload(requested);
+                return false;
+            }
+            // A preloaded scene nobody asked for is dropped for the one that was
+            delete ready;
+            ready = CreateScene(prefetchName);
+            readyName = prefetchName;
+            prefetchName.clear();
+            std::cout << "INFO: Preloaded scene " << readyName << " (" << resources.GetSummary() << ")\n";
+            return false;
+        }
+
+        if (!requested.empty()) Preload(requested);
+        return false;
+    }
+
+    // Show the ready scene, and start preloading the one after it. Returns the previous scene for the caller
+    // to delete once nothing uses it anymore (e.g. the renderer and the simulation thread)
+    Scene* Swap() {
+        Scene* previous = current;
+        current = ready;
+        currentName = readyName;
+        ready = NULL;
+        readyName.clear();
+        requested.clear();
+
+        // Scenes may change GL state in Activate, each starts from raylib's defaults
+        rlEnableBackfaceCulling();
+        current->Activate();
+
+        Preload(GetNextSceneName());
+        return previous;
+    }
+
+    Scene* GetScene() { return current; }
+    const std::string& GetSceneName() { return currentName; }
+    // Cycles through SCENE_NAMES, from the first one for scenes not in it (e.g. stress scenes)
+    std::string GetNextSceneName() {
+        auto it = std::find(SCENE_NAMES.begin(), SCENE_NAMES.end(), currentName);
+        if (it == SCENE_NAMES.end() || ++it == SCENE_NAMES.end()) return SCENE_NAMES.front();
+        return *it;
+    }
+};
+
+#endif
@@ -0,0 +1,73 @@
+#ifndef SCENES_H
+#define SCENES_H
+
+#include <string>
+#include <vector>
+#include <algorithm>
+
+#include "scene.h"
+#include "clock.h"
+#include "pong.h"
+#include "graph.h"
+#include "console.h"
+#include "tetris.h"
+#include "stress.h"
+#include "model.h"
+
+// Names accepted by CreateScene (and --scene)
+const std::vector<std::string> SCENE_NAMES = { "clock", "pong", "graph", "console", "tetris", "model" };
+// Also accepted: "stress" (5000 cubes in view) or "stress<cubes>", e.g. "stress20000",
+// and "field" (100000 cubes, mostly out of view) or "field<cubes>"
+#define STRESS_DEFAULT_CUBES 5000
+#define FIELD_DEFAULT_CUBES 100000
+
+// Cube count of a stress scene name with this prefix, 0 if it isn't one (or asks for no cubes)
+int ParseStressSceneName(const std::string& name, const std::string& prefix, int defaultCubes) {
+    if (name.rfind(prefix, 0) != 0) return 0;
+    std::string count = name.substr(prefix.size());
+    if (count.empty()) return defaultCubes;
+    // At most 9 digits always fit in an int
+    if (count.size() > 9 || count.find_first_not_of("0123456789") != std::string::npos) return 0;
+    return std::stoi(count);
+}
+
+bool IsSceneName(const std::string& name) {
+    return std::find(SCENE_NAMES.begin(), SCENE_NAMES.end(), name) != SCENE_NAMES.end()
+        || ParseStressSceneName(name, "stress", STRESS_DEFAULT_CUBES) > 0
+        || ParseStressSceneName(name, "field", FIELD_DEFAULT_CUBES) > 0;
+}
+
+// Scenes load their shaders and meshes, so this needs a GL context. NULL for unknown names
+Scene* CreateScene(const std::string& name) {
+    if (int cubes = ParseStressSceneName(name, "stress", STRESS_DEFAULT_CUBES))
+        return new StressScene(cubes, StressLayout::Block);
+    if (int cubes = ParseStressSceneName(name, "field", FIELD_DEFAULT_CUBES))
+        return new StressScene(cubes, StressLayout::Field);
+    if (name == "clock") return new ClockScene();
+    if (name == "pong") return new PongScene();
+    if (name == "graph") return new GraphScene();
+    if (name == "console") return new ConsoleScene();
+    if (name == "tetris") return new TetrisScene();
+    if (name == "model") return new ModelScene();
+    return NULL;
+}
+
+// Files CreateScene(name) loads, read ahead by SceneManager::Preload. Keep in sync with the constructors,
+// a missing file is only read on the render thread
+std::vector<std::string> GetSceneFiles(const std::string& name) {
+    const std::string LIT = "./Shaders/lit_instanced.shader";
+    const std::string LINE = "./Shaders/line_instanced.shader";
+    const std::string TEXT = "./Shaders/text.shader";
+    const std::string FONT = "./Textures/FontAtlas.png";
+    if (ParseStressSceneName(name, "stress", STRESS_DEFAULT_CUBES) || ParseStressSceneName(name, "field", FIELD_DEFAULT_CUBES))
+        return { LIT };
+    if (name == "clock") return { LIT };
+    if (name == "pong") return { LIT, TEXT, FONT };
+    if (name == "graph") return { LINE, TEXT, FONT };
+    if (name == "console") return { LINE, TEXT, FONT };
+    if (name == "tetris") return { LINE, TEXT, "./Textures/TerminusAtlas.png" };
+    if (name == "model") return { LIT, "./Models/gameboy.lkgm" };
+    return { };
+}
+
+#endif
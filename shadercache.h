@@ -0,0 +1,214 @@
+#ifndef SHADERCACHE_H
+#define SHADERCACHE_H
+
+#include "raylib.h"
+#include "rlgl.h"
+
+#include <GLES3/gl3.h>
+
+#include <chrono>
+#include <string>
+#include <vector>
+#include <cstdint>
+#include <cstring>
+#include <algorithm>
+#include <fstream>
+#include <iostream>
+#include <sys/stat.h>
+
+// raylib's MAX_SHADER_LOCATIONS, the size of Shader::locs
+#define SHADER_LOCATIONS 32
+
+// Shader around an already linked program, with the locations LoadShaderFromMemory would look up
+Shader LoadShaderFromProgram(unsigned int id)
+{
+    Shader shader = { 0 };
+    shader.id = id;
+    shader.locs = (int *)MemAlloc(SHADER_LOCATIONS*sizeof(int));
+    for (int i = 0; i < SHADER_LOCATIONS; i++) shader.locs[i] = -1;
+
+    shader.locs[SHADER_LOC_VERTEX_POSITION] = rlGetLocationAttrib(id, "vertexPosition");
+    shader.locs[SHADER_LOC_VERTEX_TEXCOORD01] = rlGetLocationAttrib(id, "vertexTexCoord");
+    shader.locs[SHADER_LOC_VERTEX_TEXCOORD02] = rlGetLocationAttrib(id, "vertexTexCoord2");
+    shader.locs[SHADER_LOC_VERTEX_NORMAL] = rlGetLocationAttrib(id, "vertexNormal");
+    shader.locs[SHADER_LOC_VERTEX_TANGENT] = rlGetLocationAttrib(id, "vertexTangent");
+    shader.locs[SHADER_LOC_VERTEX_COLOR] = rlGetLocationAttrib(id, "vertexColor");
+
+    shader.locs[SHADER_LOC_MATRIX_MVP] = rlGetLocationUniform(id, "mvp");
+    shader.locs[SHADER_LOC_MATRIX_VIEW] = rlGetLocationUniform(id, "matView");
+    shader.locs[SHADER_LOC_MATRIX_PROJECTION] = rlGetLocationUniform(id, "matProjection");
+    shader.locs[SHADER_LOC_MATRIX_MODEL] = rlGetLocationUniform(id, "matModel");
+    shader.locs[SHADER_LOC_MATRIX_NORMAL] = rlGetLocationUniform(id, "matNormal");
+
+    shader.locs[SHADER_LOC_COLOR_DIFFUSE] = rlGetLocationUniform(id, "colDiffuse");
+    shader.locs[SHADER_LOC_MAP_ALBEDO] = rlGetLocationUniform(id, "texture0");
+    shader.locs[SHADER_LOC_MAP_METALNESS] = rlGetLocationUniform(id, "texture1");
+    shader.locs[SHADER_LOC_MAP_NORMAL] = rlGetLocationUniform(id, "texture2");
+    return shader;
+}
+
+struct ShaderCacheStats {
+    int loaded = 0;             // Programs from the cache
+    int compiled = 0;           // Programs compiled from source (misses, or the cache is off)
+    int unsaved = 0;            // Compiled programs the driver returned no binary of
+    float milliseconds = 0.0f;  // Spent in both
+};
+
+// Linked programs on disk, so launches after the first skip compiling. Entries are keyed by a hash of
+// both stages' source and the GL vendor, renderer and version strings: a changed shader, define or
+// driver misses and is compiled (replacing the entry), and so is a binary the driver rejects
+class ShaderCache {
+private:
+    struct Header {
+        char magic[4];
+        uint32_t format;        // GL binary format
+        uint64_t key;
+        uint32_t length;
+    };
+
+    std::string directory;      // Empty while the cache is off
+    std::string driver;
+    ShaderCacheStats stats;
+    bool warnedUnsaved = false;
+
+    // FNV-1a
+    static uint64_t Hash(const std::string& str, uint64_t hash = 14695981039346656037ull) {
+        for (unsigned char c : str) hash = (hash ^ c) * 1099511628211ull;
+        return hash;
+    }
+
+    std::string GetPath(uint64_t key) {
+        return directory + "/" + TextFormat("%016llx", (unsigned long long)key) + ".bin";
+    }
+
+    // 0 on a miss or a binary the driver doesn't take anymore
+    unsigned int LoadBinary(uint64_t key) {
+        std::ifstream file(GetPath(key), std::ios::binary);
+        Header header;
+        if (!file.read((char *)&header, sizeof(header)) || memcmp(header.magic, "LKGS", 4) != 0 || header.key != key) return 0;
+        std::vector<char> binary(header.length);
+        if (!file.read(binary.data(), binary.size())) return 0;
+
+        GLuint program = glCreateProgram();
+        glProgramBinary(program, header.format, binary.data(), binary.size());
+        GLint linked = GL_FALSE;
+        glGetProgramiv(program, GL_LINK_STATUS, &linked);
+        if (!linked) {
+            glDeleteProgram(program);
+            return 0;
+        }
+        return program;
+    }
+
+    // Compiles and links like rlLoadShaderCode, but asks the driver to keep a binary of the program.
+    // 0 when either stage doesn't compile or the program doesn't link
+    unsigned int LinkProgram(const std::string& vertexStr, const std::string& fragmentStr) {
+        unsigned int vertex = rlCompileShader(vertexStr.c_str(), GL_VERTEX_SHADER);
+        unsigned int fragment = rlCompileShader(fragmentStr.c_str(), GL_FRAGMENT_SHADER);
+        GLint compiled = GL_FALSE;
+        if (vertex != 0) glGetShaderiv(vertex, GL_COMPILE_STATUS, &compiled);
+        if (compiled && fragment != 0) glGetShaderiv(fragment, GL_COMPILE_STATUS, &compiled);
+        else compiled = GL_FALSE;
+
+        GLuint program = 0;
+        if (compiled) {
+            program = glCreateProgram();
+            glAttachShader(program, vertex);
+            glAttachShader(program, fragment);
+            // The same attribute locations rlLoadShaderProgram binds, meshes are uploaded with them
+            glBindAttribLocation(program, RL_DEFAULT_SHADER_ATTRIB_LOCATION_POSITION, RL_DEFAULT_SHADER_ATTRIB_NAME_POSITION);
+            glBindAttribLocation(program, RL_DEFAULT_SHADER_ATTRIB_LOCATION_TEXCOORD, RL_DEFAULT_SHADER_ATTRIB_NAME_TEXCOORD);
+            glBindAttribLocation(program, RL_DEFAULT_SHADER_ATTRIB_LOCATION_NORMAL, RL_DEFAULT_SHADER_ATTRIB_NAME_NORMAL);
+            glBindAttribLocation(program, RL_DEFAULT_SHADER_ATTRIB_LOCATION_COLOR, RL_DEFAULT_SHADER_ATTRIB_NAME_COLOR);
+            glBindAttribLocation(program, RL_DEFAULT_SHADER_ATTRIB_LOCATION_TANGENT, RL_DEFAULT_SHADER_ATTRIB_NAME_TANGENT);
+            glBindAttribLocation(program, RL_DEFAULT_SHADER_ATTRIB_LOCATION_TEXCOORD2, RL_DEFAULT_SHADER_ATTRIB_NAME_TEXCOORD2);
+            // Without it drivers may not keep a binary to hand back
+            glProgramParameteri(program, GL_PROGRAM_BINARY_RETRIEVABLE_HINT, GL_TRUE);
+            glLinkProgram(program);
+
+            GLint linked = GL_FALSE;
+            glGetProgramiv(program, GL_LINK_STATUS, &linked);
+            if (!linked) {
+                glDeleteProgram(program);
+                program = 0;
+            }
+        }
+        // Only flagged while attached, freed with the program
+        if (vertex != 0) glDeleteShader(vertex);
+        if (fragment != 0) glDeleteShader(fragment);
+        return program;
+    }
+
+    void SaveBinary(uint64_t key, unsigned int program) {
+        GLint length = 0;
+        glGetProgramiv(program, GL_PROGRAM_BINARY_LENGTH, &length);
+
+        std::vector<char> binary(std::max(length, 0));
+        Header header = { { 'L', 'K', 'G', 'S' }, 0, key, 0 };
+        GLsizei written = 0;
+        if (length > 0) glGetProgramBinary(program, length, &written, &header.format, binary.data());
+        if (written <= 0) {
+            // Every launch will compile this program again
+            if (!warnedUnsaved)
+                std::cout << "WARNING: The GL driver returned no program binary, shaders won't be cached\n";
+            warnedUnsaved = true;
+            stats.unsaved++;
+            return;
+        }
+        header.length = written;
+
+        std::ofstream file(GetPath(key), std::ios::binary | std::ios::trunc);
+        file.write((const char *)&header, sizeof(header));
+        file.write(binary.data(), written);
+    }
+public:
+    // Needs a GL context. Empty (or a driver without binary formats) turns the cache off
+    void SetDirectory(const std::string& directory) {
+        this->directory.clear();
+        if (directory.empty()) return;
+
+        GLint formats = 0;
+        glGetIntegerv(GL_NUM_PROGRAM_BINARY_FORMATS, &formats);
+        if (formats == 0) {
+            std::cout << "INFO: The GL driver has no program binary formats, compiling every shader\n";
+            return;
+        }
+        mkdir(directory.c_str(), 0755);
+
+        this->directory = directory;
+        driver = std::string((const char *)glGetString(GL_VENDOR)) + "\n" + (const char *)glGetString(GL_RENDERER)
+            + "\n" + (const char *)glGetString(GL_VERSION);
+    }
+
+    // Same as LoadShaderFromMemory, from the cache when it has the program. Programs that fail to compile
+    // or link go through LoadShaderFromMemory, which logs why and falls back to the default shader
+    Shader Load(const std::string& vertexStr, const std::string& fragmentStr) {
+        auto start = std::chrono::steady_clock::now();
+        uint64_t key = Hash(fragmentStr, Hash(vertexStr, Hash(driver)));
+
+        Shader shader = { 0 };
+        unsigned int program = directory.empty() ? 0 : LoadBinary(key);
+        if (program != 0) {
+            shader = LoadShaderFromProgram(program);
+            stats.loaded++;
+        } else {
+            // Linked here rather than in LoadShaderFromMemory, to set GL_PROGRAM_BINARY_RETRIEVABLE_HINT
+            program = directory.empty() ? 0 : LinkProgram(vertexStr, fragmentStr);
+            if (program != 0) {
+                SaveBinary(key, program);
+                shader = LoadShaderFromProgram(program);
+            } else {
+                shader = LoadShaderFromMemory(vertexStr.c_str(), fragmentStr.c_str());
+            }
+            stats.compiled++;
+        }
+
+        stats.milliseconds += std::chrono::duration<float, std::milli>(std::chrono::steady_clock::now() - start).count();
+        return shader;
+    }
+
+    ShaderCacheStats GetStats() { return stats; }
+};
+ShaderCache shaderCache;
+
+#endif
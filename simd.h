@@ -0,0 +1,158 @@
+#ifndef SIMD_H
+#define SIMD_H
+
+#include "raylib.h"
+#include "raymath.h"
+
+#include <cstddef>
+#include <algorithm>
+
+// Batch versions of the per instance math of line and text generation: NEON on the Pi (and other ARM
+// boards), SSE on x86, scalar anywhere else. Each does the same multiplies and adds in the same order as
+// the raymath function it replaces, so results match it exactly as long as neither side is contracted
+// into fused multiply-adds (Tools/simd_bench.cpp is built with -ffp-contract=off and checks that they do).
+#if defined(__ARM_NEON) || defined(__ARM_NEON__)
+    #include <arm_neon.h>
+    #define SIMD_NEON
+#elif defined(__SSE2__) || defined(_M_X64)
+    #include <emmintrin.h>
+    #define SIMD_SSE
+#endif
+
+const char *GetSimdName()
+{
+#if defined(SIMD_NEON)
+    return "NEON";
+#elif defined(SIMD_SSE)
+    return "SSE2";
+#else
+    return "scalar";
+#endif
+}
+
+// out[i] = Vector3Transform(points[i], transform). out may be points
+void TransformPoints(const Vector3 *points, int count, Matrix transform, Vector3 *out)
+{
+    int i = 0;
+    // Four points at a time, deinterleaved into x, y and z lanes
+#if defined(SIMD_NEON)
+    float32x4_t m0 = vdupq_n_f32(transform.m0), m4 = vdupq_n_f32(transform.m4), m8 = vdupq_n_f32(transform.m8), m12 = vdupq_n_f32(transform.m12);
+    float32x4_t m1 = vdupq_n_f32(transform.m1), m5 = vdupq_n_f32(transform.m5), m9 = vdupq_n_f32(transform.m9), m13 = vdupq_n_f32(transform.m13);
+    float32x4_t m2 = vdupq_n_f32(transform.m2), m6 = vdupq_n_f32(transform.m6), m10 = vdupq_n_f32(transform.m10), m14 = vdupq_n_f32(transform.m14);
+    for (; i + 4 <= count; i += 4)
+    {
+        float32x4x3_t p = vld3q_f32(&points[i].x), r;
+        r.val[0] = vaddq_f32(vaddq_f32(vaddq_f32(vmulq_f32(m0, p.val[0]), vmulq_f32(m4, p.val[1])), vmulq_f32(m8, p.val[2])), m12);
+        r.val[1] = vaddq_f32(vaddq_f32(vaddq_f32(vmulq_f32(m1, p.val[0]), vmulq_f32(m5, p.val[1])), vmulq_f32(m9, p.val[2])), m13);
+        r.val[2] = vaddq_f32(vaddq_f32(vaddq_f32(vmulq_f32(m2, p.val[0]), vmulq_f32(m6, p.val[1])), vmulq_f32(m10, p.val[2])), m14);
+        vst3q_f32(&out[i].x, r);
+    }
+#elif defined(SIMD_SSE)
+    __m128 m0 = _mm_set1_ps(transform.m0), m4 = _mm_set1_ps(transform.m4), m8 = _mm_set1_ps(transform.m8), m12 = _mm_set1_ps(transform.m12);
+    __m128 m1 = _mm_set1_ps(transform.m1), m5 = _mm_set1_ps(transform.m5), m9 = _mm_set1_ps(transform.m9), m13 = _mm_set1_ps(transform.m13);
+    __m128 m2 = _mm_set1_ps(transform.m2), m6 = _mm_set1_ps(transform.m6), m10 = _mm_set1_ps(transform.m10), m14 = _mm_set1_ps(transform.m14);
+    for (; i + 4 <= count; i += 4)
+    {
+        float *p = &out[i].x;
+        // a = x0 y0 z0 x1, b = y1 z1 x2 y2, c = z2 x3 y3 z3
+        __m128 a = _mm_loadu_ps(&points[i].x), b = _mm_loadu_ps(&points[i].x + 4), c = _mm_loadu_ps(&points[i].x + 8);
+        __m128 x = _mm_shuffle_ps(a, _mm_shuffle_ps(b, c, _MM_SHUFFLE(1, 1, 2, 2)), _MM_SHUFFLE(2, 0, 3, 0));
+        __m128 y = _mm_shuffle_ps(_mm_shuffle_ps(a, b, _MM_SHUFFLE(0, 0, 1, 1)), _mm_shuffle_ps(b, c, _MM_SHUFFLE(2, 2, 3, 3)), _MM_SHUFFLE(2, 0, 2, 0));
+        __m128 z = _mm_shuffle_ps(_mm_shuffle_ps(a, b, _MM_SHUFFLE(1, 1, 2, 2)), c, _MM_SHUFFLE(3, 0, 2, 0));
+
+        __m128 rx = _mm_add_ps(_mm_add_ps(_mm_add_ps(_mm_mul_ps(m0, x), _mm_mul_ps(m4, y)), _mm_mul_ps(m8, z)), m12);
+        __m128 ry = _mm_add_ps(_mm_add_ps(_mm_add_ps(_mm_mul_ps(m1, x), _mm_mul_ps(m5, y)), _mm_mul_ps(m9, z)), m13);
+        __m128 rz = _mm_add_ps(_mm_add_ps(_mm_add_ps(_mm_mul_ps(m2, x), _mm_mul_ps(m6, y)), _mm_mul_ps(m10, z)), m14);
+
+        _mm_storeu_ps(p, _mm_shuffle_ps(_mm_shuffle_ps(rx, ry, _MM_SHUFFLE(0, 0, 0, 0)), _mm_shuffle_ps(rz, rx, _MM_SHUFFLE(1, 1, 0, 0)), _MM_SHUFFLE(2, 0, 2, 0)));
+        _mm_storeu_ps(p + 4, _mm_shuffle_ps(_mm_shuffle_ps(ry, rz, _MM_SHUFFLE(1, 1, 1, 1)), _mm_shuffle_ps(rx, ry, _MM_SHUFFLE(2, 2, 2, 2)), _MM_SHUFFLE(2, 0, 2, 0)));
+        _mm_storeu_ps(p + 8, _mm_shuffle_ps(_mm_shuffle_ps(rz, rx, _MM_SHUFFLE(3, 3, 2, 2)), _mm_shuffle_ps(ry, rz, _MM_SHUFFLE(3, 3, 3, 3)), _MM_SHUFFLE(2, 0, 2, 0)));
+    }
+#endif
+    for (; i < count; i++) out[i] = Vector3Transform(points[i], transform);
+}
+
+// MatrixToFloatV(MatrixMultiply(matrices[i], transform)), written every outStride bytes from out,
+// e.g. straight into the transforms of ModelInstances
+void MultiplyMatrices(const Matrix *matrices, int count, Matrix transform, float16 *out, size_t outStride = sizeof(float16))
+{
+    unsigned char *bytes = (unsigned char *)out;
+    int i = 0;
+    // Each matrix is loaded the way a Matrix is stored (m0 m4 m8 m12, m1 m5 m9 m13, ...) and multiplied in
+    // that order, then transposed into MatrixToFloatV's (m0 m1 m2 m3, ...)
+#if defined(SIMD_NEON) || defined(SIMD_SSE)
+    const float right[16] = {
+        transform.m0, transform.m1, transform.m2, transform.m3, transform.m4, transform.m5, transform.m6, transform.m7,
+        transform.m8, transform.m9, transform.m10, transform.m11, transform.m12, transform.m13, transform.m14, transform.m15 };
+#endif
+#if defined(SIMD_NEON)
+    float32x4_t b0 = vdupq_n_f32(right[0]), b1 = vdupq_n_f32(right[1]), b2 = vdupq_n_f32(right[2]), b3 = vdupq_n_f32(right[3]);
+    float32x4_t b4 = vdupq_n_f32(right[4]), b5 = vdupq_n_f32(right[5]), b6 = vdupq_n_f32(right[6]), b7 = vdupq_n_f32(right[7]);
+    float32x4_t b8 = vdupq_n_f32(right[8]), b9 = vdupq_n_f32(right[9]), b10 = vdupq_n_f32(right[10]), b11 = vdupq_n_f32(right[11]);
+    float32x4_t b12 = vdupq_n_f32(right[12]), b13 = vdupq_n_f32(right[13]), b14 = vdupq_n_f32(right[14]), b15 = vdupq_n_f32(right[15]);
+    for (; i < count; i++)
+    {
+        const float *left = (const float *)&matrices[i];
+        float32x4_t l0 = vld1q_f32(left), l1 = vld1q_f32(left + 4), l2 = vld1q_f32(left + 8), l3 = vld1q_f32(left + 12);
+        float32x4x4_t r;
+        r.val[0] = vaddq_f32(vaddq_f32(vaddq_f32(vmulq_f32(l0, b0), vmulq_f32(l1, b4)), vmulq_f32(l2, b8)), vmulq_f32(l3, b12));
+        r.val[1] = vaddq_f32(vaddq_f32(vaddq_f32(vmulq_f32(l0, b1), vmulq_f32(l1, b5)), vmulq_f32(l2, b9)), vmulq_f32(l3, b13));
+        r.val[2] = vaddq_f32(vaddq_f32(vaddq_f32(vmulq_f32(l0, b2), vmulq_f32(l1, b6)), vmulq_f32(l2, b10)), vmulq_f32(l3, b14));
+        r.val[3] = vaddq_f32(vaddq_f32(vaddq_f32(vmulq_f32(l0, b3), vmulq_f32(l1, b7)), vmulq_f32(l2, b11)), vmulq_f32(l3, b15));
+        // Interleaving the four vectors is the transpose
+        vst4q_f32(((float16 *)(bytes + i*outStride))->v, r);
+    }
+#elif defined(SIMD_SSE)
+    __m128 b0 = _mm_set1_ps(right[0]), b1 = _mm_set1_ps(right[1]), b2 = _mm_set1_ps(right[2]), b3 = _mm_set1_ps(right[3]);
+    __m128 b4 = _mm_set1_ps(right[4]), b5 = _mm_set1_ps(right[5]), b6 = _mm_set1_ps(right[6]), b7 = _mm_set1_ps(right[7]);
+    __m128 b8 = _mm_set1_ps(right[8]), b9 = _mm_set1_ps(right[9]), b10 = _mm_set1_ps(right[10]), b11 = _mm_set1_ps(right[11]);
+    __m128 b12 = _mm_set1_ps(right[12]), b13 = _mm_set1_ps(right[13]), b14 = _mm_set1_ps(right[14]), b15 = _mm_set1_ps(right[15]);
+    for (; i < count; i++)
+    {
+        const float *left = (const float *)&matrices[i];
+        __m128 l0 = _mm_loadu_ps(left), l1 = _mm_loadu_ps(left + 4), l2 = _mm_loadu_ps(left + 8), l3 = _mm_loadu_ps(left + 12);
+        __m128 r0 = _mm_add_ps(_mm_add_ps(_mm_add_ps(_mm_mul_ps(l0, b0), _mm_mul_ps(l1, b4)), _mm_mul_ps(l2, b8)), _mm_mul_ps(l3, b12));
+        __m128 r1 = _mm_add_ps(_mm_add_ps(_mm_add_ps(_mm_mul_ps(l0, b1), _mm_mul_ps(l1, b5)), _mm_mul_ps(l2, b9)), _mm_mul_ps(l3, b13));
+        __m128 r2 = _mm_add_ps(_mm_add_ps(_mm_add_ps(_mm_mul_ps(l0, b2), _mm_mul_ps(l1, b6)), _mm_mul_ps(l2, b10)), _mm_mul_ps(l3, b14));
+        __m128 r3 = _mm_add_ps(_mm_add_ps(_mm_add_ps(_mm_mul_ps(l0, b3), _mm_mul_ps(l1, b7)), _mm_mul_ps(l2, b11)), _mm_mul_ps(l3, b15));
+        _MM_TRANSPOSE4_PS(r0, r1, r2, r3);
+        float *v = ((float16 *)(bytes + i*outStride))->v;
+        _mm_storeu_ps(v, r0); _mm_storeu_ps(v + 4, r1); _mm_storeu_ps(v + 8, r2); _mm_storeu_ps(v + 12, r3);
+    }
+#endif
+    for (; i < count; i++) *(float16 *)(bytes + i*outStride) = MatrixToFloatV(MatrixMultiply(matrices[i], transform));
+}
+
+// ColorFromNormalized(colors[i]), clamped to [0, 1] first
+void PackColors(const Vector4 *colors, int count, Color *out)
+{
+    int i = 0;
+    // Four colors at a time, narrowed into one 16 byte store
+#if defined(SIMD_NEON)
+    float32x4_t zero = vdupq_n_f32(0.0f), one = vdupq_n_f32(1.0f), scale = vdupq_n_f32(255.0f);
+    for (; i + 4 <= count; i += 4)
+    {
+        uint16x4_t c[4];
+        for (int k = 0; k < 4; k++)
+            c[k] = vmovn_u32(vcvtq_u32_f32(vmulq_f32(vminq_f32(vmaxq_f32(vld1q_f32(&colors[i + k].x), zero), one), scale)));
+        vst1q_u8((uint8_t *)&out[i], vcombine_u8(vmovn_u16(vcombine_u16(c[0], c[1])), vmovn_u16(vcombine_u16(c[2], c[3]))));
+    }
+#elif defined(SIMD_SSE)
+    __m128 zero = _mm_setzero_ps(), one = _mm_set1_ps(1.0f), scale = _mm_set1_ps(255.0f);
+    for (; i + 4 <= count; i += 4)
+    {
+        __m128i c[4];
+        for (int k = 0; k < 4; k++)
+            c[k] = _mm_cvttps_epi32(_mm_mul_ps(_mm_min_ps(_mm_max_ps(_mm_loadu_ps(&colors[i + k].x), zero), one), scale));
+        _mm_storeu_si128((__m128i *)&out[i], _mm_packus_epi16(_mm_packs_epi32(c[0], c[1]), _mm_packs_epi32(c[2], c[3])));
+    }
+#endif
+    for (; i < count; i++)
+    {
+        Vector4 c = colors[i];
+        out[i] = Color{ (unsigned char)(Clamp(c.x, 0.0f, 1.0f)*255.0f), (unsigned char)(Clamp(c.y, 0.0f, 1.0f)*255.0f),
+            (unsigned char)(Clamp(c.z, 0.0f, 1.0f)*255.0f), (unsigned char)(Clamp(c.w, 0.0f, 1.0f)*255.0f) };
+    }
+}
+
+#endif
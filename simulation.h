@@ -0,0 +1,65 @@
+#ifndef SIMULATION_H
+#define SIMULATION_H
+
+#include <atomic>
+#include <chrono>
+#include <thread>
+#include <iostream>
+#include <algorithm>
+
+#include "scene.h"
+#include "sceneclock.h"
+
+// Runs Scene::Update on its own thread in fixed steps (see SceneClock), so simulation overlaps quilt submission.
+// Scenes hand their state to Draw through a SnapshotBuffer, see Scene::SupportsThreadedUpdate.
+// Input is read with raylib's IsKeyDown, whose state the render thread refreshes in EndDrawing.
+class SimulationThread {
+private:
+    Scene* scene;
+    TimeSource* source;
+    SceneClock clock;
+
+    std::thread thread;
+    std::atomic<bool> running{ true };
+    std::atomic<long> updates{ 0 };
+    // Source time the last step was due at, for the render thread's alpha
+    std::atomic<double> tickTime{ 0.0 };
+
+    void Run() {
+        while (running.load(std::memory_order_relaxed)) {
+            int steps = clock.Advance();
+            for (int i = 0; i < steps; i++) scene->Update(clock.GetStep());
+            updates.fetch_add(steps, std::memory_order_relaxed);
+            tickTime.store(source->Now() - clock.GetAlpha() * clock.GetStep(), std::memory_order_release);
+
+            std::this_thread::sleep_for(std::chrono::duration<double>((1.0f - clock.GetAlpha()) * clock.GetStep()));
+        }
+    }
+public:
+    SimulationThread(Scene* scene, TimeSource* source, float rate)
+        : scene(scene), source(source), clock(source, rate) {
+        tickTime = source->Now();
+        std::cout << "INFO: Updating scene on a simulation thread at " << rate << " Hz\n";
+        thread = std::thread(&SimulationThread::Run, this);
+    }
+    ~SimulationThread() {
+        running = false;
+        thread.join();
+    }
+    SimulationThread(const SimulationThread&) = delete;
+    SimulationThread& operator=(const SimulationThread&) = delete;
+
+    long GetUpdateCount() { return updates.load(std::memory_order_relaxed); }
+
+    // Render thread side of SceneClock::GetAlpha/GetRenderTime. The snapshot Draw acquires can be a step
+    // older or newer than this, alpha only smooths motion within a step
+    float GetAlpha() {
+        float alpha = (source->Now() - tickTime.load(std::memory_order_acquire)) / clock.GetStep();
+        return std::min(std::max(alpha, 0.0f), 1.0f);
+    }
+    double GetRenderTime() {
+        return std::max(0.0, (updates.load(std::memory_order_relaxed) - 1 + GetAlpha()) * clock.GetStep());
+    }
+};
+
+#endif
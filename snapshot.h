@@ -0,0 +1,36 @@
+#ifndef SNAPSHOT_H
+#define SNAPSHOT_H
+
+#include <atomic>
+
+// Latest value handoff between one writer (Scene::Update) and one reader (Scene::Draw), without locks.
+// Triple buffered: the writer fills its own slot and swaps it with the shared middle one, the reader
+// swaps the middle slot for its own only when a newer one was published. Neither side ever waits,
+// the reader just keeps drawing its current snapshot until the next one is complete.
+template <typename T>
+class SnapshotBuffer {
+private:
+    static const int FRESH = 4;     // Set on the middle index when it holds an unread snapshot
+
+    T slots[3];
+    int back = 0;                   // Owned by the writer
+    int front = 1;                  // Owned by the reader
+    std::atomic<int> middle{ 2 };
+public:
+    // Slot to fill for the next Publish, its previous contents are stale
+    T& Write() {
+        return slots[back];
+    }
+    void Publish() {
+        back = middle.exchange(back | FRESH, std::memory_order_acq_rel) & ~FRESH;
+    }
+
+    // Newest published snapshot, stays valid (and unchanged) until the next Acquire
+    const T& Acquire() {
+        if (middle.load(std::memory_order_relaxed) & FRESH)
+            front = middle.exchange(front, std::memory_order_acq_rel) & ~FRESH;
+        return slots[front];
+    }
+};
+
+#endif
@@ -0,0 +1,107 @@
+#include "raylib.h"
+#include "raymath.h"
+#include "rlgl.h"
+
+#include <cmath>
+#include <vector>
+#include <string>
+#include <iostream>
+#include <fstream>
+
+#include "scene.h"
+#include "raylib_extensions.h"
+#include "resources.h"
+
+enum class StressLayout {
+    Block,  // Everything inside the display volume
+    Field   // A flat grid of fixed spacing, mostly outside of it for large counts (culling)
+};
+
+// Synthetic load for benchmarking: small spinning lit cubes (and their shadows),
+// so the instance count can be pushed far beyond the real scenes
+class StressScene : public Scene
+{
+private:
+    int cubeCount;
+    StressLayout layout;
+
+    Shader litShader;
+    Material litMaterial;
+    Shader shadowShader;
+    ShadowPass shadow;
+
+    Mesh cubeMesh;
+public:
+    StressScene(int cubeCount, StressLayout layout) : cubeCount(cubeCount), layout(layout) {
+        std::cout << "[INITIALIZING SCENE]: Stress (" << cubeCount << " cubes"
+            << (layout == StressLayout::Field ? ", field" : "") << ")" << std::endl;
+
+        // LIT SHADER ----------
+        litShader = resources.AcquireShader("./Shaders/lit_instanced.shader", "#define COMPACT_INSTANCE\n");
+        litMaterial = LoadMaterialDefault(); // Lit material
+        litMaterial.shader = litShader;
+
+        // SHADOW SHADER ----------
+        shadowShader = resources.AcquireShader("./Shaders/lit_instanced.shader", "#define COMPACT_INSTANCE\n#define SHADOW_PASS\n");
+        shadow.material = LoadMaterialDefault(); // Shadow material
+        shadow.material.shader = shadowShader;
+        shadow.plane = PlanarShadow{ Vector3{0.0f, -3.0f, 22.0f}, -2.0f };
+
+        // MESHES ----------
+        cubeMesh = resources.AcquireMesh("cube 1", [] { return GenMeshCube(1.0f, 1.0f, 1.0f); });
+    }
+    ~StressScene() {
+        resources.ReleaseShader(litShader);
+        resources.ReleaseShader(shadowShader);
+        resources.ReleaseMesh(cubeMesh);
+        UnloadMaterialMaps(litMaterial);
+        UnloadMaterialMaps(shadow.material);
+    }
+    void Activate() {
+        SetShadowPassUniforms(shadow, Vector3{0.8f, 0.8f, 0.8f});
+    }
+    void Update(float deltaTime) { }
+    bool SupportsThreadedUpdate() { return true; }
+    void Draw(DrawList& list, double time, float alpha) {
+        float gameTime = time;
+
+        InstanceBatch<CompactInstance> instances(list.GetArena(), cubeCount);
+
+        int columns, rows, layers;
+        float spacing;
+        if (layout == StressLayout::Block) {
+            // Roughly cubic block, 4 x 5 x 1.5 units
+            int side = (int)ceil(cbrt(cubeCount / 0.3f));
+            columns = std::max(1, (int)(side * 0.8f));
+            rows = side;
+            layers = std::max(1, (cubeCount + columns * rows - 1) / (columns * rows));
+            spacing = 4.0f / columns;
+        } else {
+            // The display shows about 4 x 5 units, 100000 cubes cover 95 x 95
+            columns = rows = (int)ceil(sqrt(cubeCount));
+            layers = 1;
+            spacing = 0.3f;
+        }
+
+        for (int i = 0; i < cubeCount; i++) {
+            int x = i % columns;
+            int y = (i / columns) % rows;
+            int z = i / (columns * rows);
+
+            rlPushMatrix();
+                rlTranslatef((x - (columns - 1) * 0.5f) * spacing, (y - (rows - 1) * 0.5f) * spacing,
+                    (z - (layers - 1) * 0.5f) * spacing - 0.5f);
+                rlRotatef(gameTime * 40.0f + i * 7.0f, 1, 1, 0);
+                rlScalef(spacing * 0.5f, spacing * 0.5f, spacing * 0.5f);
+
+                instances.Push(ToCompactInstance(rlGetMatrixTransform(), ColorFromHSV(fmod(i * 2.0f, 360.0f), 0.4f, 1.0f)));
+            rlPopMatrix();
+        }
+
+        list.DrawInstances(cubeMesh, litMaterial, COMPACT_INSTANCE_LAYOUT, instances, &shadow);
+    }
+
+    Color GetClearColor() {
+        return Color{240,240,240,255};
+    }
+};
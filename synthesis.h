@@ -0,0 +1,106 @@
+#ifndef SYNTHESIS_H
+#define SYNTHESIS_H
+
+#include "raylib.h"
+#include "rlgl.h"
+
+#include <cmath>
+#include <vector>
+#include <iostream>
+
+#include "raylib_extensions.h"
+#include "quilt.h"
+
+// Sparse view rendering: only every stride-th view (plus the last one) is rendered, with depth,
+// and the views in between are reprojected from their two neighbouring key views along the
+// camera baseline (Shaders/synthesis.shader). Disocclusions in one key view are filled from the other.
+// Owns GL objects, delete before CloseWindow.
+class ViewSynthesizer {
+private:
+    int stride;
+    int viewCount;
+    Quilt* keyViews;
+
+    // Camera offset of every quilt view (see viewOffset in main.cpp)
+    std::vector<float> offsets;
+    float disparityScale;
+    float focalDistance;
+
+    Shader shader = { 0 };
+    int keyColorLoc;
+    int keyDepthLoc;
+    int viewOriginLoc;
+    int keyLayersLoc;
+    int offsetsLoc;
+public:
+    ViewSynthesizer(int stride, std::pair<int, int> tiles, std::pair<int, int> tileRes,
+            Camera3D camera, std::vector<float> offsets)
+        : stride(stride), viewCount(tiles.first * tiles.second), offsets(offsets) {
+        keyViews = new Quilt(QuiltLayout::Layered, { GetKeyViewCount(), 1 }, tileRes, true);
+
+        float aspect = (float)tileRes.first / (float)tileRes.second;
+        disparityScale = 0.5f / (tan(camera.fovy * 0.5f * DEG2RAD) * aspect);
+        focalDistance = camera.position.z;
+
+        shader = LoadShaderSingleFile("./Shaders/synthesis.shader");
+        keyColorLoc = GetShaderLocation(shader, "keyColor");
+        keyDepthLoc = GetShaderLocation(shader, "keyDepth");
+        viewOriginLoc = GetShaderLocation(shader, "viewOrigin");
+        keyLayersLoc = GetShaderLocation(shader, "keyLayers");
+        offsetsLoc = GetShaderLocation(shader, "offsets");
+
+        float tileSize[2] = { (float)tileRes.first, (float)tileRes.second };
+        SetShaderValue(shader, GetShaderLocation(shader, "tileSize"), tileSize, SHADER_UNIFORM_VEC2);
+        SetShaderValue(shader, GetShaderLocation(shader, "disparityScale"), &disparityScale, SHADER_UNIFORM_FLOAT);
+        SetShaderValue(shader, GetShaderLocation(shader, "focalDistance"), &focalDistance, SHADER_UNIFORM_FLOAT);
+        float clipPlanes[2] = { RL_CULL_DISTANCE_NEAR, RL_CULL_DISTANCE_FAR };
+        SetShaderValue(shader, GetShaderLocation(shader, "clipPlanes"), clipPlanes, SHADER_UNIFORM_VEC2);
+
+        std::cout << "INFO: Rendering " << GetKeyViewCount() << " of " << viewCount << " views, synthesizing the rest\n";
+    }
+    ~ViewSynthesizer() {
+        delete keyViews;
+        UnloadShader(shader);
+    }
+    ViewSynthesizer(const ViewSynthesizer&) = delete;
+    ViewSynthesizer& operator=(const ViewSynthesizer&) = delete;
+
+    // Key views are 0, stride, 2*stride, ... and always the last view, so every view has one on each side
+    int GetKeyViewCount() { return (viewCount - 1 + stride - 1) / stride + 1; }
+    int GetKeyView(int k) { return std::min(k * stride, viewCount - 1); }
+
+    // Render key view k (quilt view GetKeyView(k)) between BeginView and EndView of this quilt
+    Quilt* GetKeyViews() { return keyViews; }
+
+    // Fill every view of the quilt from the key views, call between quilt->Begin and quilt->End
+    void Synthesize(Quilt* quilt, Color clearColor) {
+        BeginShaderMode(shader);
+            keyViews->SetShaderTexture(shader, keyColorLoc);
+            keyViews->SetShaderDepthTexture(shader, keyDepthLoc);
+
+            for (int i = 0; i < viewCount; i++) {
+                quilt->BeginView(i, clearColor);
+
+                int left = i / stride;
+                int right = std::min(left + 1, GetKeyViewCount() - 1);
+                float keyLayers[2] = { (float)left, (float)right };
+                float viewOffsets[3] = { offsets[i], offsets[GetKeyView(left)], offsets[GetKeyView(right)] };
+
+                // In the atlas the view is a viewport inside the quilt, fragment coordinates include its origin
+                Rectangle rect = quilt->GetLayout() == QuiltLayout::Atlas ? quilt->GetViewRect(i) : Rectangle{ 0 };
+                float viewOrigin[2] = { rect.x, rect.y };
+
+                SetShaderValue(shader, keyLayersLoc, keyLayers, SHADER_UNIFORM_VEC2);
+                SetShaderValue(shader, offsetsLoc, viewOffsets, SHADER_UNIFORM_VEC3);
+                SetShaderValue(shader, viewOriginLoc, viewOrigin, SHADER_UNIFORM_VEC2);
+                quilt->FillView();
+
+                // Uniforms change per view, draw before the batch moves on
+                rlDrawRenderBatchActive();
+                quilt->EndView();
+            }
+        EndShaderMode();
+    }
+};
+
+#endif
@@ -4,6 +4,8 @@
 
 #include <cmath>
 #include <ctime>
+#include <array>
+#include <algorithm>
 #include <string>
 #include <regex>
 #include <iostream>
@@ -11,6 +13,9 @@
 
 #include "scene.h"
 #include "raylib_extensions.h"
+#include "text.h"
+#include "resources.h"
+#include "scenegraph.h"
 
 enum class Tetromino : unsigned char {
     Shape_O,
@@ -22,6 +27,37 @@ enum class Tetromino : unsigned char {
     Shape_T
 };
 
+// Acts once when a key goes down, then repeatedly after a delay while it's held. Counted in
+// simulation time (Update's deltaTime) so it doesn't depend on the frame rate
+struct KeyRepeat {
+    int key;
+    float delay;
+    float interval;         // 0 doesn't repeat
+    float held = -1.0f;     // Seconds held, negative while up
+
+    KeyRepeat(int key, float delay = 0.2f, float interval = 0.08f) : key(key), delay(delay), interval(interval) { }
+
+    // Actions up to t seconds held
+    int Count(float t) {
+        if (t < delay || interval <= 0.0f) return 1;
+        return 2 + (int)((t - delay) / interval);
+    }
+    // Whether the key acts this step
+    bool Step(float deltaTime) {
+        if (!IsKeyDown(key)) {
+            held = -1.0f;
+            return false;
+        }
+        if (held < 0.0f) {
+            held = 0.0f;
+            return true;
+        }
+        float before = held;
+        held += deltaTime;
+        return Count(held) > Count(before);
+    }
+};
+
 struct Cell {
     bool empty = true;
     Color color;
@@ -34,7 +70,7 @@ struct Dropped {
     int posY = 11;
     int rotation = 0;
 
-    constexpr Color GetColor() {
+    constexpr Color GetColor() const {
         switch (tetromino) {
             case Tetromino::Shape_O:
                 return Color{255, 255, 190, 255};
@@ -52,7 +88,7 @@ struct Dropped {
                 return Color{225, 225, 225, 255};
         }
     }
-    std::array<Vector2, 4> GetCells(int r) {
+    std::array<Vector2, 4> GetCells(int r) const {
         std::array<Vector2, 4> cells;
         switch (tetromino) {
             case Tetromino::Shape_O:
@@ -141,87 +177,107 @@ private:
 
     Shader textShader;
     Material textMaterial;
+    TextureHandle fontAtlas;    // Placeholder until loaded, read into textMaterial every Draw
 
     Mesh quadMesh;
 
-    float PackColor(Vector4 color) {
-       return floor(color.x * 128.0f + 0.5f)
-        + floor(color.z * 128.0f + 0.5f) * 129.0f
-        + floor(color.y * 128.0f + 0.5f) * 129.0f * 129.0f;
-    }
-
     // LINE
     float LINE_WIDTH = 0.15f;
     float GRAPH_SEGMENT = 0.125f;
     Color LINE_COLOR = Color{255,255,255,255};//Color{38,182,128,255};
     //const Color LINE_COLOR = Color{38,182,128,255};
-    void DrawLine(Vector3 start, Vector3 end, float width, Color color,
-            Matrix* transforms, Vector4* colors, int& instanceIdx);
-    void DrawCubeLines(float size, Color color,
-            Matrix* transforms, Vector4* colors, int& instanceIdx);
-    void DrawBGLines(float size, Color color,
-            Matrix* transforms, Vector4* colors, int& instanceIdx);
-    void DrawSquareLines(float size, Color color,
-            Matrix* transforms, Vector4* colors, int& instanceIdx);
-    void DrawCircleLines(float radius, int segments,
-            Matrix* transforms, Vector4* colors, int& instanceIdx);
+    void DrawLine(const Matrix& transform, Vector3 start, Vector3 end, float width, Color color,
+            InstanceBatch<LineInstance>& lines);
+    void DrawCubeLines(const Matrix& transform, float size, Color color,
+            InstanceBatch<LineInstance>& lines);
+    void DrawBGLines(const Matrix& transform, float size, Color color,
+            InstanceBatch<LineInstance>& lines);
+    void DrawSquareLines(const Matrix& transform, float size, Color color,
+            InstanceBatch<LineInstance>& lines);
+    void DrawCircleLines(const Matrix& transform, float radius, int segments,
+            InstanceBatch<LineInstance>& lines);
 
     // TEXT
-    void DrawChar(Matrix m, Color col, char c,
-            Matrix* transforms, Vector4* colors, int& instanceIdx);
-    void DrawText(std::string text, Color col, float scale, float charWidth,
-            Matrix* transforms, Vector4* colors, int& instanceIdx);
-    float TextWidth(std::string text, float scale);
+    const std::string BLOCK = std::string(1, (char)0);
+    TextLayoutCache textLayouts;
+    // Score strings, rebuilt when the score changes
+    int labelScore = -1;
+    std::string scoreText;
+    std::string menuScoreText;
+    void DrawText(const Matrix& transform, const std::string& text, Color col, float scale, float charWidth,
+            InstanceBatch<ModelInstance>& glyphs);
+    float TextWidth(const std::string& text, float scale);
+
+    // TRANSFORMS (see SceneGraph), built once by BuildTransforms
+    const float CUBE_WIDTH = 0.36f;
+    SceneGraph transforms;
+    SceneNode menuNode;                 // Everything slides with the menu offset
+    SceneNode boxNode;
+    SceneNode gridNode;
+    SceneNode cellNodes[10][12];
+    SceneNode cellFaceNodes[10][12][2]; // Front and back glyph of an occupied cell
+    SceneNode droppedNode;
+    SceneNode droppedCellNodes[4];
+    SceneNode scoreNode;
+    SceneNode previewCellNodes[4];
+    SceneNode menuTitleNode;
+    SceneNode menuScoreNode;
+    std::vector<LineInstance> gridDots; // Rebuilt when the grid moves
+    void BuildTransforms();
 
     // Tetris
     Cell cells[10][12];
     Dropped dropped;
-    float dropTime;
+    float dropTimer = 0.0f;
     int score = 0;
     Tetromino nextTetromino;
 
     // Menu
     bool menuOpen = false;
     float menuOffset = 0;
+    float previousMenuOffset = 0;
+
+    // Input
+    KeyRepeat leftKey = KeyRepeat(KEY_A);
+    KeyRepeat rightKey = KeyRepeat(KEY_D);
+    KeyRepeat rotateKey = KeyRepeat(KEY_W, 0.0f, 0.0f);
+    KeyRepeat menuKey = KeyRepeat(KEY_F, 0.0f, 0.0f);
+
+    // Everything Draw reads, published at the end of every Update
+    struct TetrisSnapshot {
+        Cell cells[10][12];
+        Dropped dropped;
+        int score;
+        Tetromino nextTetromino;
+        float previousMenuOffset;
+        float menuOffset;
+    };
+    SnapshotBuffer<TetrisSnapshot> snapshots;
+    void PublishSnapshot() {
+        TetrisSnapshot& snapshot = snapshots.Write();
+        std::copy(&cells[0][0], &cells[0][0] + 10 * 12, &snapshot.cells[0][0]);
+        snapshot.dropped = dropped;
+        snapshot.score = score;
+        snapshot.nextTetromino = nextTetromino;
+        snapshot.previousMenuOffset = previousMenuOffset;
+        snapshot.menuOffset = menuOffset;
+        snapshots.Publish();
+    }
 public:
     TetrisScene() {
         std::cout << "[INITIALIZING SCENE]: Tetris" << std::endl;
 
-        Vector3 shadowColor = Vector3{0.0f, 0.0f, 0.0f};
-        Vector3 lightPos = Vector3{0.0f, -3.0f, 22.0f};
-        float planeZ = -2.0f;
-        
         // LINE SHADER ----------
-        lineShader = LoadShaderSingleFile("./Shaders/line_instanced.shader");
-        lineShader.locs[SHADER_LOC_MATRIX_MODEL] = GetShaderLocationAttrib(lineShader, "matModel");
-        lineShader.locs[SHADER_LOC_COLOR_DIFFUSE] = GetShaderLocationAttrib(lineShader, "direction");
-        lineShader.locs[SHADER_LOC_MATRIX_VIEW] = GetShaderLocation(lineShader, "matView");
-        lineShader.locs[SHADER_LOC_MATRIX_PROJECTION] = GetShaderLocation(lineShader, "matProjection");
-        float glow = 0.0f;
-        float glowFalloff = 15.0f;
-        SetShaderValue(lineShader, GetShaderLocation(lineShader, "glow"), &glow, SHADER_UNIFORM_FLOAT);
-        SetShaderValue(lineShader, GetShaderLocation(lineShader, "glowFalloff"), &glowFalloff, SHADER_UNIFORM_FLOAT);
-
+        lineShader = resources.AcquireShader("./Shaders/line_instanced.shader");
         lineMaterial = LoadMaterialDefault(); // Line material
         lineMaterial.shader = lineShader;
 
-        rlDisableBackfaceCulling();
-
         // TEXT SHADER ----------
-        textShader = LoadShaderSingleFile("./Shaders/text.shader");
-        textShader.locs[SHADER_LOC_MATRIX_MODEL] = GetShaderLocationAttrib(textShader, "matModel");
-        textShader.locs[SHADER_LOC_COLOR_DIFFUSE] = GetShaderLocationAttrib(textShader, "colDiffuse");
-        textShader.locs[SHADER_LOC_MATRIX_VIEW] = GetShaderLocation(textShader, "matView");
-        textShader.locs[SHADER_LOC_MATRIX_PROJECTION] = GetShaderLocation(textShader, "matProjection");
-
-        //Vector2 atlasSize = Vector2{15, 8};
-        Vector2 atlasSize = Vector2{14, 12};
-        SetShaderValue(textShader, GetShaderLocation(textShader, "atlasSize"), &atlasSize, SHADER_UNIFORM_VEC2);
-
-        textShader.locs[SHADER_LOC_MAP_ALBEDO] = GetShaderLocation(textShader, "texture1");
+        textShader = resources.AcquireShader("./Shaders/text.shader");
 
         MaterialMap fontAtlasMap = { 0 };
-        fontAtlasMap.texture = LoadTexture("./Textures/TerminusAtlas.png");
+        fontAtlas = resources.AcquireTexture("./Textures/TerminusAtlas.png");
+        fontAtlasMap.texture = fontAtlas.Get();
         fontAtlasMap.color = WHITE;
 
         textMaterial = LoadMaterialDefault(); // Text material
@@ -229,23 +285,38 @@ public:
         textMaterial.maps[0] = fontAtlasMap;
 
         // MESHES ----------
-        quadMesh = GenMeshPlaneY(1.0f, 1.0f, 1, 1);
+        quadMesh = resources.AcquireMesh("planeY 1 1", [] { return GenMeshPlaneY(1.0f, 1.0f, 1, 1); });
 
         // MISC ----------
+        BuildTransforms();
         nextTetromino = static_cast<Tetromino>(GetRandomValue(0,6));
-        dropTime = GetTime();
+        PublishSnapshot();
     }
     ~TetrisScene() {
-        UnloadShader(lineShader);
-        UnloadShader(textShader);
+        resources.ReleaseShader(lineShader);
+        resources.ReleaseShader(textShader);
+        resources.ReleaseTexture(fontAtlas);
+        resources.ReleaseMesh(quadMesh);
+        UnloadMaterialMaps(lineMaterial);
+        UnloadMaterialMaps(textMaterial);
     }
-    void Update() {
-        float deltaTime = GetFrameTime();
-        float gameTime = GetTime();
+    void Activate() {
+        float glow = 0.0f;
+        float glowFalloff = 15.0f;
+        SetShaderValue(lineShader, GetShaderLocation(lineShader, "glow"), &glow, SHADER_UNIFORM_FLOAT);
+        SetShaderValue(lineShader, GetShaderLocation(lineShader, "glowFalloff"), &glowFalloff, SHADER_UNIFORM_FLOAT);
+
+        //Vector2 atlasSize = Vector2{15, 8};
+        Vector2 atlasSize = Vector2{14, 12};
+        SetShaderValue(textShader, GetShaderLocation(textShader, "atlasSize"), &atlasSize, SHADER_UNIFORM_VEC2);
 
+        rlDisableBackfaceCulling();
+    }
+    void Update(float deltaTime) {
         if (!menuOpen) {
-            if ((gameTime - dropTime) > (IsKeyDown(KEY_S) ? 0.05f : 0.5f)) {
-                dropTime = gameTime;
+            dropTimer += deltaTime;
+            if (dropTimer > (IsKeyDown(KEY_S) ? 0.05f : 0.5f)) {
+                dropTimer = 0.0f;
                 if (dropped.CanMove(cells, Vector2{0, -1})) {
                     dropped.posY -= 1;
                 } else {
@@ -292,122 +363,102 @@ public:
                     }
                 }
             }
-            if (IsKeyDown(KEY_A) && dropped.CanMove(cells, Vector2{-1, 0})) {
+            if (leftKey.Step(deltaTime) && dropped.CanMove(cells, Vector2{-1, 0})) {
                 dropped.posX -= 1;
             }
-            if (IsKeyDown(KEY_D) && dropped.CanMove(cells, Vector2{1, 0})) {
+            if (rightKey.Step(deltaTime) && dropped.CanMove(cells, Vector2{1, 0})) {
                 dropped.posX += 1;
             }
-            if (IsKeyDown(KEY_W) && dropped.CanRotate(cells, true)) {
+            if (rotateKey.Step(deltaTime) && dropped.CanRotate(cells, true)) {
                 dropped.Rotate(true);
             }
         }
 
-        if (IsKeyDown(KEY_F)) {
+        if (menuKey.Step(deltaTime)) {
             menuOpen = !menuOpen;
         }
+        previousMenuOffset = menuOffset;
         menuOffset = Lerp(menuOffset, menuOpen ? -2.0f : 0.0f, deltaTime * 2.0f);
-    }
-    void Draw() {
-        float gameTime = GetTime();
-
-        Matrix lineTransforms[1500];
-        Vector4 lineColors[1500];
-        int lineInstanceIdx = 0;
 
-        Matrix textTransforms[1500];
-        Vector4 textColors[1500];
-        int textInstanceIdx = 0;
+        PublishSnapshot();
+    }
+    bool SupportsThreadedUpdate() { return true; }
+    void Draw(DrawList& list, double time, float alpha) {
+        textMaterial.maps[0].texture = fontAtlas.Get();
+        const TetrisSnapshot& state = snapshots.Acquire();
+        float menuOffset = Lerp(state.previousMenuOffset, state.menuOffset, alpha);
+        float gameTime = time;
+
+        InstanceBatch<LineInstance> lines(list.GetArena());
+        InstanceBatch<ModelInstance> glyphs(list.GetArena());
+        if (state.score != labelScore) {
+            labelScore = state.score;
+            scoreText = std::to_string(state.score);
+            menuScoreText = "Score: " + scoreText;
+        }
 
-        const float CUBE_WIDTH = 0.36f;
+        // Only what moved since the last frame is recomputed
+        transforms.SetTranslation(menuNode, Vector3{ menuOffset, 0, 0 });
+        transforms.SetTranslation(droppedNode, Vector3{ CUBE_WIDTH * state.dropped.posX, CUBE_WIDTH * state.dropped.posY, 0 });
+        std::array<Vector2, 4> droppedCells = state.dropped.GetCells(state.dropped.rotation);
+        for (int i = 0; i < 4; i++)
+            transforms.SetTranslation(droppedCellNodes[i], Vector3{ CUBE_WIDTH * droppedCells[i].x, CUBE_WIDTH * droppedCells[i].y, 0 });
+        Dropped preview = Dropped{state.nextTetromino};
+        std::array<Vector2, 4> previewCells = preview.GetCells(0);
+        for (int i = 0; i < 4; i++)
+            transforms.SetTranslation(previewCellNodes[i], Vector3{ previewCells[i].x * 0.1f, previewCells[i].y * 0.1f, 0 });
+        // Tilted by the renderer like the matrix stack is (see QuiltRenderer::RenderQuilt)
+        transforms.SetBase(rlGetMatrixTransform());
+        transforms.Update();
 
         // Containing box
         LINE_WIDTH = 0.25f;
-        rlPushMatrix();
-            rlTranslatef(0.0f + menuOffset, -0.35f, 0);
-            rlRotatef(-15.0f, 1, 0, 0);
-            rlScalef(1.8f, 2.2f, 1.0f * CUBE_WIDTH);
-
-            this->DrawBGLines(1.0f, WHITE,
-                    lineTransforms, lineColors, lineInstanceIdx);
-        rlPopMatrix();
+        this->DrawBGLines(transforms.GetWorld(boxNode), 1.0f, WHITE,
+                lines);
         LINE_WIDTH = 0.15f;
-        
-        // Tetrominoes
-        rlPushMatrix();
-            rlTranslatef(0.0f + menuOffset, -0.35f, 0);
-            rlRotatef(-15.0f, 1, 0, 0);
-            rlTranslatef(4.5f * -CUBE_WIDTH, -2.2f + 0.5*CUBE_WIDTH, 0);
-
-            rlPushMatrix();
-                //Grid
-                for (int y = 0; y < 12; y++) {
-                    for (int x = 0; x < 10; x++) {
-                        //Dot
-                        if (y < 11 && x < 9)
-                            this->DrawLine(Vector3{CUBE_WIDTH/2.0f,-0.025f + CUBE_WIDTH/2.0f, 0}, Vector3{CUBE_WIDTH/2.0f,0.025f + CUBE_WIDTH/2.0f, 0},
-                                    LINE_WIDTH, WHITE, lineTransforms, lineColors, lineInstanceIdx);
-                        //Occupied cells
-                        if (!cells[x][y].empty) {
-                            Color c = cells[x][y].color;
-                            rlTranslatef(0, 0, CUBE_WIDTH * 0.5f);
-                            this->DrawText(std::string(1, (char)0), c,
-                                    CUBE_WIDTH * 1.05f, 1.0f, textTransforms, textColors, textInstanceIdx);
-                            rlTranslatef(0, 0, -2.0f * CUBE_WIDTH * 0.5f);
-                            this->DrawText(std::string(1, (char)0), Color{c.r-25,c.g-25,c.b-25,c.a},
-                                    CUBE_WIDTH * 1.05f, 1.0f, textTransforms, textColors, textInstanceIdx);
-                            rlTranslatef(0, 0, CUBE_WIDTH * 0.5f);
-                        }
-                        rlTranslatef(CUBE_WIDTH, 0, 0);
-                    }
-                    rlTranslatef(-CUBE_WIDTH * 10, 0, 0);
-                    rlTranslatef(0, CUBE_WIDTH, 0);
+
+        // Grid, rebuilt when it moves (the base matrix too)
+        if (transforms.HasChanged(gridNode)) {
+            gridDots.clear();
+            for (int y = 0; y < 11; y++) {
+                for (int x = 0; x < 9; x++) {
+                    gridDots.push_back(LineInstance{
+                        transforms.TransformPoint(cellNodes[x][y], Vector3{CUBE_WIDTH/2.0f,-0.025f + CUBE_WIDTH/2.0f, 0}),
+                        transforms.TransformPoint(cellNodes[x][y], Vector3{CUBE_WIDTH/2.0f,0.025f + CUBE_WIDTH/2.0f, 0}),
+                        LINE_WIDTH, WHITE });
                 }
-            rlPopMatrix();
-
-            //Dropped
-            rlTranslatef(CUBE_WIDTH * dropped.posX, CUBE_WIDTH * dropped.posY, 0);
-            for (Vector2 cellPos : dropped.GetCells(dropped.rotation)) {
-                rlPushMatrix();
-                rlTranslatef(CUBE_WIDTH * cellPos.x, CUBE_WIDTH * cellPos.y, 0);
-                    this->DrawCubeLines(CUBE_WIDTH/2.0f, dropped.GetColor(),
-                            lineTransforms, lineColors, lineInstanceIdx);
-                rlPopMatrix();
             }
-        rlPopMatrix();
-
-        rlPushMatrix();
-            rlTranslatef(-1.5f + menuOffset, 2.3f, -0.575f);
-            this->DrawText(std::to_string(score), LINE_COLOR, 0.6f, 0.5f,
-                    textTransforms, textColors, textInstanceIdx);
-
-            rlTranslatef(3.0f, 0, 0);
-            Dropped preview = Dropped{nextTetromino};
-            for (Vector2 cell : preview.GetCells(0)) {
-                rlPushMatrix();
-                    float s = 0.1f;
-                    rlTranslatef(cell.x * s, cell.y * s, 0);
-                    this->DrawText(std::string(1, (char)0), RAYWHITE,
-                            s, 1.0f, textTransforms, textColors, textInstanceIdx);
-                rlPopMatrix();
+        }
+        std::copy(gridDots.begin(), gridDots.end(), lines.Append(gridDots.size()));
+
+        // Tetrominoes
+        for (int y = 0; y < 12; y++) {
+            for (int x = 0; x < 10; x++) {
+                if (state.cells[x][y].empty) continue;
+                Color c = state.cells[x][y].color;
+                this->DrawText(transforms.GetWorld(cellFaceNodes[x][y][0]), BLOCK, c, CUBE_WIDTH * 1.05f, 1.0f, glyphs);
+                this->DrawText(transforms.GetWorld(cellFaceNodes[x][y][1]), BLOCK, Color{c.r-25,c.g-25,c.b-25,c.a}, CUBE_WIDTH * 1.05f, 1.0f, glyphs);
             }
-        rlPopMatrix();
+        }
+
+        //Dropped
+        for (int i = 0; i < 4; i++) {
+            this->DrawCubeLines(transforms.GetWorld(droppedCellNodes[i]), CUBE_WIDTH/2.0f, state.dropped.GetColor(),
+                    lines);
+        }
+
+        this->DrawText(transforms.GetWorld(scoreNode), scoreText, LINE_COLOR, 0.6f, 0.5f, glyphs);
+        for (int i = 0; i < 4; i++) this->DrawText(transforms.GetWorld(previewCellNodes[i]), BLOCK, RAYWHITE, 0.1f, 1.0f, glyphs);
 
         // Menu
         if (abs(menuOffset) > 0.05f) {
-            rlPushMatrix();
-                rlTranslatef(2.35f + menuOffset, 2.1f, -0.5f);
-                this->DrawText("Tetris", LINE_COLOR, 0.7f, 0.5f,
-                        textTransforms, textColors, textInstanceIdx);
-                rlTranslatef(0, -1.0f, -0.5f);
-                this->DrawText("Score: " + std::to_string(score), LINE_COLOR, 0.45f, 0.5f,
-                        textTransforms, textColors, textInstanceIdx);
-            rlPopMatrix();
+            this->DrawText(transforms.GetWorld(menuTitleNode), "Tetris", LINE_COLOR, 0.7f, 0.5f, glyphs);
+            this->DrawText(transforms.GetWorld(menuScoreNode), menuScoreText, LINE_COLOR, 0.45f, 0.5f, glyphs);
         }
 
         // Draw Instanced
-        DrawMeshInstancedC(quadMesh, lineMaterial, lineTransforms, lineColors, lineInstanceIdx);
-        DrawMeshInstancedC(quadMesh, textMaterial, textTransforms, textColors, textInstanceIdx);
+        list.DrawInstances(quadMesh, lineMaterial, LINE_INSTANCE_LAYOUT, lines);
+        list.DrawInstances(quadMesh, textMaterial, MODEL_INSTANCE_LAYOUT, glyphs);
     }
 
     Color GetClearColor() {
@@ -424,125 +475,83 @@ public:
     bool ShowFPS() { return true; };
 };
 
+/* TRANSFORMS */
+
+// Same layout the scene used to build on rlgl's matrix stack every frame
+void TetrisScene::BuildTransforms() {
+    menuNode = transforms.Create();
+    SceneNode boardNode = transforms.Create(menuNode, Vector3{ 0, -0.35f, 0 }, QuaternionFromAxisAngle(Vector3{ 1, 0, 0 }, -15.0f*DEG2RAD));
+    boxNode = transforms.Create(boardNode, Vector3Zero(), QuaternionIdentity(), Vector3{ 1.8f, 2.2f, 1.0f * CUBE_WIDTH });
+    gridNode = transforms.Create(boardNode, Vector3{ 4.5f * -CUBE_WIDTH, -2.2f + 0.5f*CUBE_WIDTH, 0 });
+    for (int y = 0; y < 12; y++) {
+        for (int x = 0; x < 10; x++) {
+            cellNodes[x][y] = transforms.Create(gridNode, Vector3{ CUBE_WIDTH * x, CUBE_WIDTH * y, 0 });
+            cellFaceNodes[x][y][0] = transforms.Create(cellNodes[x][y], Vector3{ 0, 0, CUBE_WIDTH * 0.5f });
+            cellFaceNodes[x][y][1] = transforms.Create(cellNodes[x][y], Vector3{ 0, 0, -CUBE_WIDTH * 0.5f });
+        }
+    }
+    droppedNode = transforms.Create(gridNode);
+    for (int i = 0; i < 4; i++) droppedCellNodes[i] = transforms.Create(droppedNode);
+
+    scoreNode = transforms.Create(menuNode, Vector3{ -1.5f, 2.3f, -0.575f });
+    SceneNode previewNode = transforms.Create(scoreNode, Vector3{ 3.0f, 0, 0 });
+    for (int i = 0; i < 4; i++) previewCellNodes[i] = transforms.Create(previewNode);
+
+    menuTitleNode = transforms.Create(menuNode, Vector3{ 2.35f, 2.1f, -0.5f });
+    menuScoreNode = transforms.Create(menuTitleNode, Vector3{ 0, -1.0f, -0.5f });
+}
+
 /* TEXT DRAWING FUNCTIONS */
 
-void TetrisScene::DrawChar(Matrix m, Color col, char c,
-        Matrix* transforms, Vector4* colors, int& instanceIdx) {
-    colors[instanceIdx] = ColorNormalize(Color{col.r,col.g,col.b,c/*-32*/});
-    transforms[instanceIdx++] = m;
-};
-void TetrisScene::DrawText(std::string text, Color col, float scale, float charWidth,
-        Matrix* transforms, Vector4* colors, int& instanceIdx) {
-    rlPushMatrix();
-        rlScalef(scale, scale, scale);
-        for (char c : text) {
-            if (c != 32) {
-                this->DrawChar(MatrixMultiply(MatrixScale(charWidth, 1.0f, 1.0f), rlGetMatrixTransform()),
-                        col, c, transforms, colors, instanceIdx);
-            }
-            rlTranslatef(0.4f, 0, 0);
-        }
-    rlPopMatrix();
+// One cache lookup, the glyphs are laid out once per distinct string
+void TetrisScene::DrawText(const Matrix& transform, const std::string& text, Color col, float scale, float charWidth,
+        InstanceBatch<ModelInstance>& glyphs) {
+    DrawGlyphRun(textLayouts.Get(text, TERMINUS_ATLAS, scale, charWidth), transform, col, glyphs);
 };
-float TetrisScene::TextWidth(std::string text, float scale) {
-    return text.length() * (scale * 0.4f);
+float TetrisScene::TextWidth(const std::string& text, float scale) {
+    return text.length() * (scale * TERMINUS_ATLAS.advance);
 }
 
 /* LINE DRAWING FUNCTIONS */
 
-void TetrisScene::DrawLine(Vector3 start, Vector3 end, float width, Color color,
-        Matrix* transforms, Vector4* colors, int& instanceIdx) {
-    Vector3 midpoint = Vector3Lerp(start, end, 0.5f);
-    Vector3 direction = Vector3Normalize(Vector3Subtract(end, start));
-    float distance = Vector3Distance(end, start);
-
-    // Matrix Transformation
-    Matrix matTranslation = MatrixTranslate(midpoint.x, midpoint.y, midpoint.z);
-    Matrix matScale = MatrixScale(/*width*/0.0f, distance, 1.0f);
-
-    Quaternion fromToRotation = QuaternionFromVector3ToVector3(Vector3{0,1.0f,0}, direction);
-    Matrix matRotation = QuaternionToMatrix(fromToRotation);
-    Matrix matTransform = MatrixMultiply(MatrixMultiply(matScale, matRotation), matTranslation);
-
-    // Line screen direction
-    Matrix matModelView = MatrixMultiply(rlGetMatrixTransform(), rlGetMatrixModelview());
-    Matrix mvp = MatrixMultiply(matModelView, rlGetMatrixProjection());
-
-    Vector4 projStart = Vector4Transform(Vector4{start.x,start.y,start.z,1.0f}, mvp);
-    Vector2 screenStart = Vector2Scale(Vector2{projStart.x, projStart.y}, 1.0f/projStart.w);
-    screenStart.x *= 1536.0f/2048.0f;
-    Vector4 projEnd = Vector4Transform(Vector4{end.x,end.y,end.z,1.0f}, mvp);
-    Vector2 screenEnd = Vector2Scale(Vector2{projEnd.x, projEnd.y}, 1.0f/projEnd.w);
-    screenEnd.x *= 1536.0f/2048.0f;
-    Vector2 screenDir = Vector2Normalize(Vector2Subtract(screenEnd, screenStart));
-
-    // Instance values
-    colors[instanceIdx] = Vector4{screenDir.x,screenDir.y,width,this->PackColor(ColorNormalize(color))};
-    transforms[instanceIdx++] = MatrixMultiply(matTransform, rlGetMatrixTransform());
+void TetrisScene::DrawLine(const Matrix& transform, Vector3 start, Vector3 end, float width, Color color,
+        InstanceBatch<LineInstance>& lines) {
+    // Expanded into a quad facing each view in the shader
+    lines.Push(LineInstance{ Vector3Transform(start, transform), Vector3Transform(end, transform), width, color });
 }
-void TetrisScene::DrawCubeLines(float s, Color c, Matrix* transforms, Vector4* colors, int& instanceIdx) {
-    this->DrawLine(Vector3{s, s, s}, Vector3{-s, s, s}, LINE_WIDTH, c,
-            transforms, colors, instanceIdx); // -
-    this->DrawLine(Vector3{s, -s, s}, Vector3{-s, -s, s}, LINE_WIDTH, c,
-            transforms, colors, instanceIdx);
-    this->DrawLine(Vector3{s, s, -s}, Vector3{-s, s, -s}, LINE_WIDTH, c,
-            transforms, colors, instanceIdx);
-    this->DrawLine(Vector3{s, -s, -s}, Vector3{-s, -s, -s}, LINE_WIDTH, c,
-            transforms, colors, instanceIdx);
-    this->DrawLine(Vector3{s, s, s}, Vector3{s, s, -s}, LINE_WIDTH, c,
-            transforms, colors, instanceIdx); // -
-    this->DrawLine(Vector3{s, -s, s}, Vector3{s, -s, -s}, LINE_WIDTH, c,
-            transforms, colors, instanceIdx);
-    this->DrawLine(Vector3{-s, s, s}, Vector3{-s, s, -s}, LINE_WIDTH, c,
-            transforms, colors, instanceIdx);
-    this->DrawLine(Vector3{-s, -s, s}, Vector3{-s, -s, -s}, LINE_WIDTH, c,
-            transforms, colors, instanceIdx);
-    this->DrawLine(Vector3{s, s, s}, Vector3{s, -s, s}, LINE_WIDTH, c,
-            transforms, colors, instanceIdx); // -
-    this->DrawLine(Vector3{s, s, -s}, Vector3{s, -s, -s}, LINE_WIDTH, c,
-            transforms, colors, instanceIdx);
-    this->DrawLine(Vector3{-s, s, s}, Vector3{-s, -s, s}, LINE_WIDTH, c,
-            transforms, colors, instanceIdx);
-    this->DrawLine(Vector3{-s, s, -s}, Vector3{-s, -s, -s}, LINE_WIDTH, c,
-            transforms, colors, instanceIdx);
+void TetrisScene::DrawCubeLines(const Matrix& transform, float s, Color c, InstanceBatch<LineInstance>& lines) {
+    Vector3 edges[24];
+    for (int i = 0; i < 24; i++) edges[i] = Vector3Scale(CUBE_EDGE_LINES[i], s);
+    AppendLineInstances(transform, edges, 24, LINE_WIDTH, c,
+            lines);
 }
-void TetrisScene::DrawBGLines(float s, Color c, Matrix* transforms, Vector4* colors, int& instanceIdx) {
-    this->DrawLine(Vector3{s, s, -s}, Vector3{-s, s, -s}, LINE_WIDTH, c,
-            transforms, colors, instanceIdx); // -
-    this->DrawLine(Vector3{s, -s, -s}, Vector3{-s, -s, -s}, LINE_WIDTH, c,
-            transforms, colors, instanceIdx);
-
-    this->DrawLine(Vector3{s, s, s}, Vector3{s, -s, s}, LINE_WIDTH, c,
-            transforms, colors, instanceIdx);
-    this->DrawLine(Vector3{-s, s, s}, Vector3{-s, -s, s}, LINE_WIDTH, c,
-            transforms, colors, instanceIdx);
-
-    this->DrawLine(Vector3{s, s, s}, Vector3{s, s, -s}, LINE_WIDTH, c,
-            transforms, colors, instanceIdx);
-    this->DrawLine(Vector3{-s, s, s}, Vector3{-s, s, -s}, LINE_WIDTH, c,
-            transforms, colors, instanceIdx);
-    this->DrawLine(Vector3{-s, -s, s}, Vector3{-s, -s, -s}, LINE_WIDTH, c,
-            transforms, colors, instanceIdx);
-    this->DrawLine(Vector3{s, -s, s}, Vector3{s, -s, -s}, LINE_WIDTH, c,
-            transforms, colors, instanceIdx);
+void TetrisScene::DrawBGLines(const Matrix& transform, float s, Color c, InstanceBatch<LineInstance>& lines) {
+    // The cube's edges but the front's top and bottom and the back's sides
+    const Vector3 edges[16] = {
+        {s, s, -s}, {-s, s, -s},    {s, -s, -s}, {-s, -s, -s},
+        {s, s, s}, {s, -s, s},      {-s, s, s}, {-s, -s, s},
+        {s, s, s}, {s, s, -s},      {-s, s, s}, {-s, s, -s},    {-s, -s, s}, {-s, -s, -s},    {s, -s, s}, {s, -s, -s},
+    };
+    AppendLineInstances(transform, edges, 16, LINE_WIDTH, c,
+            lines);
 }
-void TetrisScene::DrawSquareLines(float s, Color c, Matrix* transforms, Vector4* colors, int& instanceIdx) {
-    this->DrawLine(Vector3{s, s, 0}, Vector3{-s, s, 0}, LINE_WIDTH, c,
-            transforms, colors, instanceIdx); // -
-    this->DrawLine(Vector3{s, -s, 0}, Vector3{-s, -s, 0}, LINE_WIDTH, c,
-            transforms, colors, instanceIdx);
-    this->DrawLine(Vector3{s, s, 0}, Vector3{s, -s, 0}, LINE_WIDTH, c,
-            transforms, colors, instanceIdx);
-    this->DrawLine(Vector3{-s, s, 0}, Vector3{-s, -s, 0}, LINE_WIDTH, c,
-            transforms, colors, instanceIdx);
+void TetrisScene::DrawSquareLines(const Matrix& transform, float s, Color c, InstanceBatch<LineInstance>& lines) {
+    this->DrawLine(transform, Vector3{s, s, 0}, Vector3{-s, s, 0}, LINE_WIDTH, c,
+            lines); // -
+    this->DrawLine(transform, Vector3{s, -s, 0}, Vector3{-s, -s, 0}, LINE_WIDTH, c,
+            lines);
+    this->DrawLine(transform, Vector3{s, s, 0}, Vector3{s, -s, 0}, LINE_WIDTH, c,
+            lines);
+    this->DrawLine(transform, Vector3{-s, s, 0}, Vector3{-s, -s, 0}, LINE_WIDTH, c,
+            lines);
 }
-void TetrisScene::DrawCircleLines(float radius, int segments, Matrix* transforms, Vector4* colors, int& instanceIdx) {
+void TetrisScene::DrawCircleLines(const Matrix& transform, float radius, int segments, InstanceBatch<LineInstance>& lines) {
     for (int i = 0; i < segments; i++) {
         float angle = ((float)i/(float)segments) * PI * 2.0f;
         float next_angle = ((float)(i+1)/(float)segments) * PI * 2.0f;
         auto p = Vector3{cos(angle), sin(angle), 0};
         auto n = Vector3{cos(next_angle), sin(next_angle), 0};
-        this->DrawLine(Vector3Scale(p, radius), Vector3Scale(n, radius), LINE_WIDTH, LINE_COLOR,
-                transforms, colors, instanceIdx);
+        this->DrawLine(transform, Vector3Scale(p, radius), Vector3Scale(n, radius), LINE_WIDTH, LINE_COLOR,
+                lines);
     }
 }
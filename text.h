@@ -0,0 +1,106 @@
+#ifndef TEXT_H
+#define TEXT_H
+
+#include "raylib.h"
+#include "raymath.h"
+
+#include <map>
+#include <tuple>
+#include <string>
+#include <vector>
+#include <functional>
+
+#include "raylib_extensions.h"
+
+// How a font atlas maps characters to glyphs, drawn by Shaders/text.shader as quads whose
+// colDiffuse alpha is the glyph index
+struct TextFont {
+    int id;             // Distinguishes fonts in a TextLayoutCache
+    int firstGlyph;     // Character of the atlas' first glyph
+    char blank;         // Character that takes up space without drawing a glyph
+    float advance;      // Character spacing, in units of the text scale
+};
+
+// Textures/FontAtlas.png, printable ASCII from the space on
+const TextFont FONT_ATLAS = { 0, 32, 0, 0.4f };
+// Textures/TerminusAtlas.png, starts at character 0 (the full block)
+const TextFont TERMINUS_ATLAS = { 1, 0, ' ', 0.4f };
+
+// A laid out string: glyph transforms relative to the string's origin, only multiplied by the
+// base transform when drawn
+struct GlyphRun {
+    std::vector<Matrix> transforms;
+    std::vector<unsigned char> glyphs;
+    float width;    // Along x, from the origin
+};
+
+GlyphRun LayoutText(const std::string& text, const TextFont& font, float scale, float charWidth)
+{
+    GlyphRun run;
+    run.width = text.length() * font.advance * scale;
+    Matrix glyphScale = MatrixMultiply(MatrixScale(charWidth, 1.0f, 1.0f), MatrixScale(scale, scale, scale));
+    for (size_t i = 0; i < text.length(); i++) {
+        if (text[i] == font.blank) continue;
+        run.transforms.push_back(MatrixMultiply(glyphScale, MatrixTranslate(i * font.advance * scale, 0, 0)));
+        run.glyphs.push_back((unsigned char)(text[i] - font.firstGlyph));
+    }
+    return run;
+}
+
+// Appends the run's glyphs as text shader instances
+void DrawGlyphRun(const GlyphRun& run, Matrix transform, Color color, InstanceBatch<ModelInstance>& instances)
+{
+    if (run.glyphs.empty()) return;
+    ModelInstance *first = instances.Append(run.glyphs.size());
+    // Every glyph's transform in one batch (see simd.h), written straight into the instances
+    MultiplyMatrices(run.transforms.data(), run.transforms.size(), transform, &first->transform, sizeof(ModelInstance));
+    Vector4 normalized = ColorNormalize(color);
+    for (size_t i = 0; i < run.glyphs.size(); i++) {
+        normalized.w = run.glyphs[i] / 255.0f;
+        first[i].color = normalized;
+    }
+}
+
+// Glyph runs by (string, font, scale, char width), laid out on first use. A string that changes is a
+// new key, the least recently used runs are dropped once there are more than capacity
+class TextLayoutCache {
+private:
+    typedef std::tuple<int, float, float, std::string> Key;
+    struct Entry {
+        GlyphRun run;
+        unsigned long lastUse;
+    };
+
+    std::map<Key, Entry, std::less<>> runs;    // Transparent, lookups don't copy the string
+    size_t capacity;
+    unsigned long uses = 0;
+public:
+    TextLayoutCache(size_t capacity = 64) : capacity(capacity) { }
+
+    // Valid until the next Get
+    const GlyphRun& Get(const std::string& text, const TextFont& font, float scale, float charWidth = 1.0f) {
+        uses++;
+        auto found = runs.find(std::forward_as_tuple(font.id, scale, charWidth, text));
+        if (found != runs.end()) {
+            found->second.lastUse = uses;
+            return found->second.run;
+        }
+
+        if (runs.size() >= capacity) {
+            auto oldest = runs.begin();
+            for (auto it = runs.begin(); it != runs.end(); ++it) {
+                if (it->second.lastUse < oldest->second.lastUse) oldest = it;
+            }
+            runs.erase(oldest);
+        }
+        Entry& entry = runs[Key(font.id, scale, charWidth, text)];
+        entry.run = LayoutText(text, font, scale, charWidth);
+        entry.lastUse = uses;
+        return entry.run;
+    }
+
+    void Clear() { runs.clear(); }
+    size_t Size() { return runs.size(); }
+};
+
+#endif